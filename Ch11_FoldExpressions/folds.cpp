@@ -1,6 +1,8 @@
 #include <iostream>
 #include <type_traits>
 
+#include "format_to.hpp"
+
 /**
  * C++17 introduced `fold expressions`:
  * - left fold:
@@ -78,10 +80,18 @@ void print5(T const& first, Ts const&... args)
     std::cout << "\n";
 }
 
+// The same without std::cout: println() in format_to.hpp folds the arguments into a per-thread
+// buffer instead - with std::to_chars for numbers - which is written with one syscall when full:
+template <auto Sep = ' ', typename T, typename... Ts>
+void print6(T const& first, Ts const&... args)
+{
+    println<Sep>(first, args...);
+}
+
 // Fold expressions can also be used to implement type-traits operating on template parameter packs:
 template<typename T, typename... Ts>
 struct IsHomogenous {
-    static constexpr bool value{... && std::is_same_v<T, Ts>};
+    static constexpr bool value{(... && std::is_same_v<T, Ts>)};   // the parentheses are required
 };
 
 template<typename T, typename... Ts>
@@ -93,4 +103,10 @@ constexpr bool isHomogenous(T, Ts...)
     return (... && std::is_same_v<T, Ts>);
 }
 
-int main() {}
+int main()
+{
+    print5<','>(42, "answer", 2.5);
+    std::cout.flush();  // print6 writes past the buffer of std::cout
+    print6<','>(42, "answer", 2.5);
+    static_assert(IsHomogenousV<int, int, int> && !isHomogenous(1, 2.0));
+}
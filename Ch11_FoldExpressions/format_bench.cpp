@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "format_to.hpp"
+
+/**
+ * Writes trace records - "<step> <name> <value> <ok>" - to stdout, with std::cout as print5() in
+ * folds.cpp does, and with println() from format_to.hpp, and reports the times on stderr:
+ *
+ *     format_bench [--count <n>] > /dev/null
+ *
+ * First it checks that format_to() gives the same text as std::ostream for integers, characters,
+ * strings and bools (with std::boolalpha) - floating-point numbers differ on purpose: to_chars
+ * writes the shortest form which reads back the same, std::ostream 6 significant digits.
+ */
+
+template <auto Sep = ' ', typename T, typename... Ts>
+void print5(T const& first, Ts const&... args)
+{
+    std::cout << first;
+    auto const print_with_sep = [](auto const& arg) { std::cout << Sep << arg; };
+    (..., print_with_sep(args));
+    std::cout << "\n";
+}
+
+bool same_as_ostream()
+{
+    OutBuffer out{-1};   // never flushed
+    std::ostringstream expected;
+    expected << std::boolalpha;
+    auto const both = [&](auto const&... args) {
+        format_to(out, args...);
+        (expected << ... << args);
+    };
+    both(0, -1, 42u, -9223372036854775807LL - 1, 18446744073709551615ULL, short{-7});
+    both('x', "literal", std::string{"string"}, std::string_view{"view"}, true, false);
+    both(static_cast<unsigned char>(200), static_cast<signed char>(-100));
+    return out.view() == expected.str()
+           || (std::cerr << "MISMATCH: " << out.view() << " vs " << expected.str() << '\n', false);
+}
+
+template <typename F>
+void measure(char const* name, std::size_t count, F&& f)
+{
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    f();
+    duration<double> const elapsed{steady_clock::now() - start};
+    std::cerr << name << ": " << elapsed.count() * 1000 << " ms, "
+              << static_cast<double>(count) / elapsed.count() / 1e6 << " M records/s\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count{2'000'000};
+    for (int i{1}; i < argc; i += 2) {
+        if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--count <n>] > /dev/null\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (!same_as_ostream()) {
+        return EXIT_FAILURE;
+    }
+
+    constexpr std::string_view names[]{"parse", "plan", "execute", "commit"};
+    std::cout << std::boolalpha;
+    measure("std::cout, print5", count, [&] {
+        for (std::size_t i{0}; i < count; ++i) {
+            print5(i, names[i % 4], static_cast<double>(i) * 0.25, i % 3 == 0);
+        }
+        std::cout.flush();
+    });
+    measure("println (format_to)", count, [&] {
+        for (std::size_t i{0}; i < count; ++i) {
+            println(i, names[i % 4], static_cast<double>(i) * 0.25, i % 3 == 0);
+        }
+        thread_buffer().flush();
+    });
+}
@@ -0,0 +1,157 @@
+#if !defined(FORMAT_TO_INCLUDE_HEADER_GUARD_)
+#define FORMAT_TO_INCLUDE_HEADER_GUARD_
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// The print helpers in folds.cpp stream each argument through std::cout: a virtual call, the
+// locale and the sentry (and the sync with C stdio) per argument. format_to() is the same fold,
+// but each argument is appended straight to a buffer - numbers with std::to_chars - and the
+// buffer goes to the file descriptor with a single write() when it's full or flushed.
+//
+// There is one buffer per thread (thread_buffer(), for stdout), which grows for a long record but
+// is otherwise reused, so formatting doesn't allocate. A buffer is flushed only between records,
+// so records of different threads don't interleave within a write() - but there's no order with
+// std::cout, which has a buffer of its own.
+class OutBuffer
+{
+public:
+    explicit OutBuffer(int fd = 1, std::size_t flush_at = 64 * 1024)
+        : data_{new char[flush_at]}, capacity_{flush_at}, flush_at_{flush_at}, fd_{fd} { }
+
+    OutBuffer(OutBuffer const&) = delete;
+    OutBuffer& operator=(OutBuffer const&) = delete;
+    ~OutBuffer() { flush(); }
+
+    // Room for `n` more characters, at the returned pointer. commit() says where they end.
+    char* prepare(std::size_t n)
+    {
+        if (capacity_ - size_ < n) {
+            auto const capacity = std::max(capacity_ * 2, size_ + n);
+            std::unique_ptr<char[]> grown{new char[capacity]};
+            std::memcpy(grown.get(), data_.get(), size_);
+            data_ = std::move(grown);
+            capacity_ = capacity;
+        }
+        return data_.get() + size_;
+    }
+
+    void commit(char const* end) noexcept { size_ = static_cast<std::size_t>(end - data_.get()); }
+
+    void append(std::string_view s)
+    {
+        std::memcpy(prepare(s.size()), s.data(), s.size());
+        size_ += s.size();
+    }
+
+    std::string_view view() const noexcept { return {data_.get(), size_}; }
+
+    // Writes what's buffered (if full, with `when_full`), returns false on a write error.
+    bool flush(bool when_full = false) noexcept
+    {
+        if (when_full && size_ < flush_at_) {
+            return true;
+        }
+        std::size_t written{0};
+        while (written < size_) {
+#if defined(_WIN32)
+            auto const n = ::_write(fd_, data_.get() + written,
+                                    static_cast<unsigned>(size_ - written));
+#else
+            auto const n = ::write(fd_, data_.get() + written, size_ - written);
+#endif
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                size_ = 0;
+                return false;
+            }
+            written += static_cast<std::size_t>(n);     // a pipe may take less at once
+        }
+        size_ = 0;
+        return true;
+    }
+
+private:
+    std::unique_ptr<char[]> data_;     // not zeroed, unlike a std::string
+    std::size_t size_{0};
+    std::size_t capacity_;
+    std::size_t flush_at_;
+    int fd_;
+};
+
+// The buffer of this thread for stdout, flushed when the thread ends.
+inline OutBuffer& thread_buffer()
+{
+    thread_local OutBuffer buffer{1};
+    return buffer;
+}
+
+namespace detail {
+
+template <typename T>
+void put(OutBuffer& out, T const& arg)
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        out.append(arg ? "true" : "false");
+    }
+    else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char>
+                       || std::is_same_v<T, unsigned char>) {
+        auto* const p = out.prepare(1);     // a character, as with std::ostream
+        *p = static_cast<char>(arg);
+        out.commit(p + 1);
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        auto* const p = out.prepare(24);      // 20 digits and a sign for 64 bits
+        out.commit(std::to_chars(p, p + 24, arg).ptr);
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        // the shortest form which reads back as the same value - more with long double
+        auto* const p = out.prepare(64);
+        out.commit(std::to_chars(p, p + 64, arg).ptr);
+    }
+    else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+        out.append(std::string_view{arg});       // strings, string_views, string literals
+    }
+    else {
+        static_assert(std::is_convertible_v<T const&, std::string_view>,
+                      "format_to: only numbers, bool, char and strings");
+    }
+}
+
+} // namespace detail
+
+// Appends all `args`, like print1() in folds.cpp - a fold over the comma operator.
+template <typename... Ts>
+void format_to(OutBuffer& out, Ts const&... args)
+{
+    (..., detail::put(out, args));
+}
+
+// Like print5() in folds.cpp: the arguments with `Sep` in between and a newline, as one record in
+// the buffer of this thread.
+template <auto Sep = ' ', typename T, typename... Ts>
+void println(T const& first, Ts const&... args)
+{
+    auto& out = thread_buffer();
+    format_to(out, first);
+    (..., format_to(out, Sep, args));
+    format_to(out, '\n');
+    out.flush(true);
+}
+
+#endif // FORMAT_TO_INCLUDE_HEADER_GUARD_
@@ -0,0 +1,130 @@
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "static_format.hpp"
+
+// The format string as a template argument - see static_format.hpp - against the same string
+// parsed at runtime for each call, and against std::snprintf(), for a log line.
+
+// a pointer to it can be a template argument: static storage, and a constant
+static constexpr char log_line[]{"[{}] request {:x} from {} took {} ms, ok={}, {{retry}}\n"};
+
+// Parses the same syntax as static_format::format_to() for each call, with the arguments as
+// already converted strings - the printf-like way.
+char* runtime_format(char* p, std::string_view fmt, std::string_view const* args)
+{
+    for (std::size_t i{0}; i < fmt.size(); ++i) {
+        if ((fmt[i] == '{' || fmt[i] == '}') && i + 1 < fmt.size() && fmt[i + 1] == fmt[i]) {
+            *p++ = fmt[i++];
+        }
+        else if (fmt[i] == '{') {
+            i = fmt.find('}', i);
+            auto const arg = *args++;
+            std::memcpy(p, arg.data(), arg.size());
+            p += arg.size();
+        }
+        else {
+            *p++ = fmt[i];
+        }
+    }
+    return p;
+}
+
+template <typename F>
+void measure(char const* name, std::size_t count, F&& f)
+{
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    auto const bytes = f();
+    duration<double> const elapsed{steady_clock::now() - start};
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << elapsed.count() * 1000 << " ms "
+              << std::setw(7) << static_cast<double>(count) / elapsed.count() / 1e6
+              << " M lines/s (" << bytes << " bytes)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t const count{argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000};
+    std::string_view const worker{"worker-7"};
+    std::string_view const peer{"10.0.0.42"};
+
+    // the same text from all three - snprintf() with an integer for the duration, as %g and
+    // std::to_chars() differ for some doubles
+    bool same{true};
+    for (std::size_t i{0}; i < 10'000; ++i) {
+        char a[256];
+        auto const r = static_format::format_to<log_line>(a, std::end(a), worker, i * 2654435761u,
+                                                         peer, i % 1000, i % 3 != 0);
+        char b[256];
+        auto const n = std::snprintf(b, sizeof(b), "[%s] request %zx from %s took %zu ms, ok=%s, "
+                                     "{retry}\n", worker.data(), i * 2654435761u, peer.data(),
+                                     i % 1000, i % 3 != 0 ? "true" : "false");
+        same = same && r.ec == std::errc{}
+               && std::string_view(a, static_cast<std::size_t>(r.ptr - a))
+                      == std::string_view(b, static_cast<std::size_t>(n));
+    }
+    std::string text;
+    static_format::format<log_line>(text, worker, 255, peer, 12.5, false);
+    std::cout << text << (same ? "same as snprintf for 10000 lines\n" : "MISMATCH with snprintf\n");
+
+    // too small: nothing past the end, and value_too_large
+    char small[16];
+    auto const r =
+        static_format::format_to<log_line>(small, std::end(small), worker, 1, peer, 2, 3);
+    std::cout << "in 16 chars: "
+              << (r.ec == std::errc::value_too_large ? "value_too_large\n" : "UNEXPECTED\n");
+
+    // static_format::format_to<log_line>(small, std::end(small), worker);    // ERROR - 1 of 5
+    //                                                          // arguments, at compile time
+    // static constexpr char broken[]{"{} took {ms"};
+    // static_format::format_to<broken>(small, std::end(small), 1);   // ERROR - no '}'
+
+    measure("snprintf", count, [&] {
+        std::size_t bytes{0};
+        char line[256];
+        for (std::size_t i{0}; i < count; ++i) {
+            bytes += static_cast<std::size_t>(std::snprintf(
+                line, sizeof(line), "[%s] request %zx from %s took %zu ms, ok=%s, {retry}\n",
+                worker.data(), i, peer.data(), i % 1000, i % 3 != 0 ? "true" : "false"));
+        }
+        return bytes;
+    });
+    measure("parsed per call", count, [&] {
+        std::size_t bytes{0};
+        char line[256];
+        for (std::size_t i{0}; i < count; ++i) {
+            char hex[24];
+            char ms[24];
+            std::string_view const args[]{
+                worker,
+                {hex, static_cast<std::size_t>(std::to_chars(hex, std::end(hex), i, 16).ptr - hex)},
+                peer,
+                {ms, static_cast<std::size_t>(std::to_chars(ms, std::end(ms), i % 1000).ptr - ms)},
+                i % 3 != 0 ? "true" : "false"};
+            bytes += static_cast<std::size_t>(runtime_format(line, log_line, args) - line);
+        }
+        return bytes;
+    });
+    measure("static_format", count, [&] {
+        std::size_t bytes{0};
+        char line[256];
+        for (std::size_t i{0}; i < count; ++i) {
+            bytes += static_cast<std::size_t>(
+                static_format::format_to<log_line>(line, std::end(line), worker, i, peer, i % 1000,
+                                                   i % 3 != 0)
+                    .ptr
+                - line);
+        }
+        return bytes;
+    });
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
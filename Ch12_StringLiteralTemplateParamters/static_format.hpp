@@ -0,0 +1,219 @@
+#if !defined(STATIC_FORMAT_INCLUDE_HEADER_GUARD_)
+#define STATIC_FORMAT_INCLUDE_HEADER_GUARD_
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Formatting with the format string as a template argument - a `char const*` to a constexpr array,
+// which is valid since C++17 (see str_literal_params.cpp; a string literal itself still isn't):
+//
+//     static constexpr char point[]{"x={} y={} id={:x}"};
+//     auto const r = static_format::format_to<point>(first, last, 1.5, -2, 255u);
+//
+// The string is parsed when the template is instantiated, at compile time, into segments: literal
+// text, and the arguments. At runtime there's nothing left to parse - the literals are copied with
+// a memcpy of a constant size, and the arguments converted, with std::to_chars for numbers.
+//
+// Also the mistakes are found at compile time: a '{' or '}' without its pair, an unknown format
+// spec, more or fewer arguments than "{}"s, and "{:x}" for an argument which isn't an integer.
+// Braces are written as "{{" and "}}".
+namespace static_format {
+
+struct Segment {
+    std::size_t begin{0};       // literal text: [begin, begin + size) of the format string
+    std::size_t size{0};
+    bool argument{false};
+    std::size_t index{0};       // of the argument
+    int base{10};               // for integer arguments: 16 with "{:x}"
+};
+
+namespace detail {
+
+constexpr std::size_t length(char const* s)
+{
+    std::size_t n{0};
+    while (s[n] != '\0') {
+        ++n;
+    }
+    return n;
+}
+
+// Splits `fmt` into segments - only counts them if `out` is null. Throwing isn't a constant
+// expression, so in a constexpr context it's a compile error, which shows the message.
+constexpr std::size_t parse(char const* fmt, Segment* out)
+{
+    std::size_t count{0};
+    std::size_t arguments{0};
+    auto const emit = [&](Segment s) {
+        if (out) {
+            out[count] = s;
+        }
+        ++count;
+    };
+    auto const n = length(fmt);
+    std::size_t literal{0};     // where the current literal text began
+    for (std::size_t i{0}; i < n; ++i) {
+        if (fmt[i] == '}') {
+            if (i + 1 == n || fmt[i + 1] != '}') {
+                throw std::invalid_argument{"format string: '}' without '{' - write }} for '}'"};
+            }
+            emit(Segment{literal, i + 1 - literal, false, 0, 10});     // up to one '}'
+            literal = ++i + 1;
+        }
+        else if (fmt[i] == '{') {
+            if (i + 1 < n && fmt[i + 1] == '{') {
+                emit(Segment{literal, i + 1 - literal, false, 0, 10});
+                literal = ++i + 1;
+                continue;
+            }
+            if (i != literal) {
+                emit(Segment{literal, i - literal, false, 0, 10});
+            }
+            int base{10};
+            if (i + 3 < n && fmt[i + 1] == ':' && fmt[i + 2] == 'x') {
+                base = 16;
+                i += 2;
+            }
+            if (i + 1 == n || fmt[i + 1] != '}') {
+                throw std::invalid_argument{"format string: expected {} or {:x}"};
+            }
+            emit(Segment{0, 0, true, arguments++, base});
+            literal = ++i + 1;
+        }
+    }
+    if (literal != n) {
+        emit(Segment{literal, n - literal, false, 0, 10});
+    }
+    return count;
+}
+
+template <char const* Fmt>
+struct Parsed {
+    static constexpr std::size_t count{parse(Fmt, nullptr)};
+    static constexpr std::array<Segment, count> segments{[] {
+        std::array<Segment, count> s{};
+        parse(Fmt, s.data());
+        return s;
+    }()};
+    static constexpr std::size_t arguments{[] {
+        std::size_t n{0};
+        for (auto const& s : segments) {
+            n += s.argument ? 1 : 0;
+        }
+        return n;
+    }()};
+};
+
+template <typename T>
+char* put(char* p, char* last, T const& value, int base) noexcept
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        return put(p, last, std::string_view{value ? "true" : "false"}, base);
+    }
+    else if constexpr (std::is_same_v<T, char>) {
+        if (p == last) {
+            return nullptr;
+        }
+        *p = value;
+        return p + 1;
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        auto const r = std::to_chars(p, last, value, base);
+        return r.ec == std::errc{} ? r.ptr : nullptr;
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        auto const r = std::to_chars(p, last, value);
+        return r.ec == std::errc{} ? r.ptr : nullptr;
+    }
+    else {
+        static_assert(std::is_convertible_v<T const&, std::string_view>,
+                      "static_format: only numbers, bool, char and strings");
+        std::string_view const s{value};
+        if (static_cast<std::size_t>(last - p) < s.size()) {
+            return nullptr;
+        }
+        std::memcpy(p, s.data(), s.size());
+        return p + s.size();
+    }
+}
+
+// Segment I - nullptr if it doesn't fit.
+template <char const* Fmt, std::size_t I, typename Args>
+char* segment(char* p, char* last, Args const& args) noexcept
+{
+    constexpr auto s = Parsed<Fmt>::segments[I];
+    if constexpr (s.argument) {
+        using T = std::decay_t<std::tuple_element_t<s.index, Args>>;
+        static_assert(s.base == 10 || std::is_integral_v<T>,
+                      "static_format: {:x} needs an integer");
+        return put(p, last, std::get<s.index>(args), s.base);
+    }
+    else {
+        if (static_cast<std::size_t>(last - p) < s.size) {
+            return nullptr;
+        }
+        std::memcpy(p, Fmt + s.begin, s.size);
+        return p + s.size;
+    }
+}
+
+template <char const* Fmt, typename Args, std::size_t... I>
+char* segments(char* p, char* last, Args const& args, std::index_sequence<I...>) noexcept
+{
+    // stops at the first which doesn't fit
+    (void)(... && ((p = segment<Fmt, I>(p, last, args)) != nullptr));
+    return p;
+}
+
+} // namespace detail
+
+// Formats `args` into [first, last), like std::to_chars: returns {past the end, {}}, or
+// {last, value_too_large} if it doesn't fit.
+template <char const* Fmt, typename... Ts>
+std::to_chars_result format_to(char* first, char* last, Ts const&... args) noexcept
+{
+    using Parsed = detail::Parsed<Fmt>;
+    static_assert(sizeof...(Ts) == Parsed::arguments,
+                  "static_format: the number of arguments doesn't match the {}s");
+    auto* const end = detail::segments<Fmt>(first, last, std::forward_as_tuple(args...),
+                                           std::make_index_sequence<Parsed::count>{});
+    if (!end) {
+        return {last, std::errc::value_too_large};
+    }
+    return {end, std::errc{}};
+}
+
+// Appends to `out` - with a buffer on the stack first, so a short text takes one append.
+template <char const* Fmt, typename... Ts>
+void format(std::string& out, Ts const&... args)
+{
+    char buffer[256];
+    auto const r = format_to<Fmt>(buffer, std::end(buffer), args...);
+    if (r.ec == std::errc{}) {
+        out.append(buffer, r.ptr);
+        return;
+    }
+    for (auto size = out.size() + 2 * sizeof(buffer);; size *= 2) {
+        auto const old = out.size();
+        out.resize(size);
+        auto const grown = format_to<Fmt>(out.data() + old, out.data() + out.size(), args...);
+        out.resize(grown.ec == std::errc{} ? static_cast<std::size_t>(grown.ptr - out.data())
+                                           : old);
+        if (grown.ec == std::errc{}) {
+            return;
+        }
+    }
+}
+
+} // namespace static_format
+
+#endif // STATIC_FORMAT_INCLUDE_HEADER_GUARD_
@@ -16,8 +16,8 @@ void foo()
     Message<hello> msg;     // OK for all C++ versions
     Message<hello11> msg11; // OK since C++11
     Message<hello17> msg17; // OK since C++17
-    Message<"Hello"> msg_;  // ERROR - invalid for all current C++ versions,
-                            // might be OK in C++20
+    // Message<"Hello"> msg_;  // ERROR - invalid for all current C++ versions,
+                               // might be OK in C++20
 }
 
 // This also solves another issue - it is now possible to use a compiletime function
@@ -0,0 +1,21 @@
+#ifndef AS_INT_HEADER_GUARD
+#define AS_INT_HEADER_GUARD
+
+#include <charconv>
+#include <optional>
+#include <string_view>
+
+// example usage of std::string_view
+inline std::optional<int> asInt(std::string_view sv)
+{
+    int val;
+    // read character sequence into the int:
+    auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), val);
+    // if we have an error code, return no value:
+    if (ec != std::errc{}) {
+        return std::nullopt;
+    }
+    return val;
+}
+
+#endif // AS_INT_HEADER_GUARD
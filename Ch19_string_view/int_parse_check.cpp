@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fast_int.hpp>
+#include "as_int.hpp"
+
+/**
+ * Checks fast_int::from_chars() (see include/fast_int.hpp) against std::from_chars, and measures
+ * both.
+ *
+ * The differential fuzzing generates inputs around the edges of the contract - the limits of each
+ * type +-2, any number of leading zeros, signs, 20+ digit overflows, junk right after the digits,
+ * bytes next to '0' and '9' - and requires the same ptr, ec and value from both for every integer
+ * type, the same result from asInt() and its fast_int equivalent, and from from_chars_fixed()
+ * the same as a digit-only field through std::from_chars.
+ *
+ * The benchmark parses comma separated values - a mix of IDs, counters and nanosecond timestamps,
+ * and timestamps only - and reports the best of 5 runs.
+ *
+ *     int_parse_check [--iterations <n>] [--seed <n>] [--count <n>]
+ */
+
+std::optional<int> asIntFast(std::string_view sv)
+{
+    int val;
+    auto [ptr, ec] = fast_int::from_chars(sv.data(), sv.data() + sv.size(), val);
+    if (ec != std::errc{}) {
+        return std::nullopt;
+    }
+    return val;
+}
+
+class Fuzzer
+{
+public:
+    explicit Fuzzer(std::uint64_t seed) : rng_{seed} { }
+
+    std::string next()
+    {
+        std::string s;
+        switch (pick(4)) {
+        case 0: s = limit(); break;
+        case 1: s = digits(); break;
+        case 2: s = bytes(); break;
+        default: s = std::to_string(static_cast<std::int64_t>(rng_())); break;
+        }
+        if (pick(2) == 0) {
+            s += bytes();   // whatever follows in the buffer
+        }
+        return s;
+    }
+
+private:
+    std::size_t pick(std::size_t n) { return rng_() % n; }
+
+    std::string zeros() { return std::string(pick(4) == 0 ? pick(24) : 0, '0'); }
+
+    std::string sign()
+    {
+        auto const n = pick(8);
+        return n == 0 ? "-" : n == 1 ? "+" : "";
+    }
+
+    // a limit of some integer type, +-2
+    std::string limit()
+    {
+        static std::int64_t const lows[]{std::numeric_limits<std::int8_t>::min(),
+                                          std::numeric_limits<std::int16_t>::min(),
+                                          std::numeric_limits<std::int32_t>::min(),
+                                          std::numeric_limits<std::int64_t>::min(), 0};
+        static std::uint64_t const highs[]{std::numeric_limits<std::int8_t>::max(),
+                                           std::numeric_limits<std::uint8_t>::max(),
+                                           std::numeric_limits<std::int16_t>::max(),
+                                           std::numeric_limits<std::uint16_t>::max(),
+                                           std::numeric_limits<std::int32_t>::max(),
+                                           std::numeric_limits<std::uint32_t>::max(),
+                                           std::numeric_limits<std::int64_t>::max(),
+                                           std::numeric_limits<std::uint64_t>::max()};
+        auto const delta = static_cast<int>(pick(5)) - 2;
+        if (pick(3) == 0) {
+            // the magnitude of a minimum, as the digits after '-'
+            auto const low = lows[pick(std::size(lows))];
+            auto const magnitude = std::uint64_t{0} - static_cast<std::uint64_t>(low);
+            return "-" + zeros() + std::to_string(magnitude + static_cast<std::uint64_t>(delta));
+        }
+        auto const high = highs[pick(std::size(highs))];
+        if (high == std::numeric_limits<std::uint64_t>::max() && delta > 0) {
+            return sign() + zeros() + "1844674407370955161" + std::to_string(5 + delta);
+        }
+        return sign() + zeros() + std::to_string(high + static_cast<std::uint64_t>(delta));
+    }
+
+    std::string digits()
+    {
+        std::string s = sign() + zeros();
+        for (auto n = pick(26); n != 0; --n) {
+            s += static_cast<char>('0' + pick(10));
+        }
+        return s;
+    }
+
+    std::string bytes()
+    {
+        static constexpr char alphabet[]{"0123456789-+ ,.\n/:\x7f\xb0\xb9\xff\x30"};
+        std::string s;
+        for (auto n = pick(12); n != 0; --n) {
+            s += alphabet[pick(sizeof(alphabet) - 1)];
+        }
+        return s;
+    }
+
+    std::mt19937_64 rng_;
+};
+
+template <typename T>
+bool same(std::string const& s)
+{
+    auto const* const first = s.data();
+    auto const* const last = s.data() + s.size();
+    // sentinels, to see values written on errors
+    T expected{static_cast<T>(42)};
+    T actual{static_cast<T>(42)};
+    auto const a = std::from_chars(first, last, expected);
+    auto const b = fast_int::from_chars(first, last, actual);
+    if (a.ptr == b.ptr && a.ec == b.ec && expected == actual) {
+        return true;
+    }
+    std::cerr << "MISMATCH for \"" << s << "\" (" << sizeof(T) * 8
+              << (std::is_signed_v<T> ? " bit signed" : " bit unsigned") << "): std "
+              << a.ptr - first << '/' << static_cast<int>(a.ec) << '/' << +expected << ", fast "
+              << b.ptr - first << '/' << static_cast<int>(b.ec) << '/' << +actual << '\n';
+    return false;
+}
+
+bool same_fixed(std::string const& s)
+{
+    auto const* const first = s.data();
+    auto const* const last = s.data() + s.size();
+    bool ok{true};
+    for (std::size_t width{1}; width <= s.size() && width <= 22; ++width) {
+        std::uint64_t expected{42};
+        std::uint64_t actual{42};
+        std::from_chars_result a{first, std::errc::invalid_argument};
+        if (std::all_of(first, first + width, [](char c) { return c >= '0' && c <= '9'; })) {
+            a = std::from_chars(first, first + width, expected);
+        }
+        auto const b = fast_int::from_chars_fixed(first, last, width, actual);
+        if (a.ptr != b.ptr || a.ec != b.ec || expected != actual) {
+            std::cerr << "MISMATCH for \"" << s << "\" fixed width " << width << '\n';
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+struct Sample {
+    std::string name{};
+    std::string text{};
+    std::size_t values{0};
+};
+
+// Either a mix of IDs, counters and timestamps, or 19 digit timestamps only.
+Sample sample(std::size_t count, std::uint64_t seed, bool mixed)
+{
+    Sample s;
+    s.name = mixed ? "mixed" : "timestamps";
+    std::mt19937_64 rng{seed};
+    char digits[24];
+    for (std::size_t i{0}; i < count; ++i) {
+        std::int64_t v;
+        switch (mixed ? rng() % 3 : 2) {
+        case 0: v = static_cast<std::int64_t>(rng() % 100'000); break;                 // IDs
+        case 1: v = static_cast<std::int64_t>(rng() % 2'000'000'000) - 1'000'000'000; break;
+        default: v = 1'760'000'000'000'000'000 + static_cast<std::int64_t>(rng() % 1'000'000'000);
+        }
+        s.text.append(digits, std::to_chars(digits, digits + sizeof(digits), v).ptr);
+        s.text += ',';
+    }
+    s.values = count;
+    return s;
+}
+
+// The best of several runs of parse(first, last), which returns the sum of the values.
+template <typename F>
+std::int64_t measure(std::string const& name, Sample const& s, F&& parse)
+{
+    using namespace std::chrono;
+    std::int64_t sum{0};
+    duration<double> best{duration<double>::max()};
+    for (int i{0}; i < 5; ++i) {
+        auto const start = steady_clock::now();
+        sum = parse(s.text.data(), s.text.data() + s.text.size());
+        best = std::min<duration<double>>(best, steady_clock::now() - start);
+    }
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << best.count() * 1000 << " ms "
+              << std::setw(8) << static_cast<double>(s.values) / best.count() / 1e6
+              << " M values/s " << std::setw(8)
+              << static_cast<double>(s.text.size()) / best.count() / 1e6 << " MB/s\n";
+    return sum;
+}
+
+template <typename Parse>
+auto summing(Parse parse)
+{
+    return [parse](char const* p, char const* last) {
+        std::int64_t sum{0};
+        while (p < last) {
+            std::int64_t v{0};
+            auto const r = parse(p, last, v);
+            sum += v;
+            p = r.ptr + 1;
+        }
+        return sum;
+    };
+}
+
+// Times all parsers on `s`, returns false if they don't agree.
+bool benchmark(Sample const& s)
+{
+    auto const expected = measure("std::from_chars, " + s.name, s,
+                                  summing([](auto p, auto last, auto& v) {
+                                      return std::from_chars(p, last, v);
+                                  }));
+    auto const actual = measure("fast_int::from_chars, " + s.name, s,
+                                summing([](auto p, auto last, auto& v) {
+                                    return fast_int::from_chars(p, last, v);
+                                }));
+    std::vector<std::int64_t> values;
+    auto const listed = measure("fast_int::parse_list, " + s.name, s,
+                                [&](char const* p, char const* last) {
+        values.clear();     // keeps its capacity for the next run
+        fast_int::parse_list(p, last, ',', values);
+        std::int64_t sum{0};
+        for (auto const v : values) {
+            sum += v;
+        }
+        return sum;
+    });
+    bool ok = expected == actual && expected == listed;
+    if (s.name == "timestamps") {
+        auto const fixed = measure("fast_int::from_chars_fixed, " + s.name, s,
+                                   summing([](auto p, auto last, auto& v) {
+                                       return fast_int::from_chars_fixed(p, last, 19, v);
+                                   }));
+        ok = ok && expected == fixed;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    std::uint64_t iterations{1'000'000};
+    std::uint64_t seed{1};
+    std::size_t count{5'000'000};
+    for (int i{1}; i + 1 < argc; i += 2) {
+        auto const value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--iterations") == 0) {
+            iterations = value;
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0) {
+            seed = value;
+        }
+        else if (std::strcmp(argv[i], "--count") == 0) {
+            count = value;
+        }
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--iterations <n>] [--seed <n>] [--count <n>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    Fuzzer fuzzer{seed};
+    std::uint64_t failures{0};
+    for (std::uint64_t i{0}; i < iterations && failures < 20; ++i) {
+        auto const s = fuzzer.next();
+        bool const ok = same<std::int8_t>(s) && same<std::uint8_t>(s) && same<std::int16_t>(s)
+                        && same<std::uint16_t>(s) && same<std::int32_t>(s)
+                        && same<std::uint32_t>(s) && same<std::int64_t>(s)
+                        && same<std::uint64_t>(s) && asInt(s) == asIntFast(s) && same_fixed(s);
+        failures += ok ? 0 : 1;
+    }
+    std::cout << iterations << " fuzzed inputs, " << failures << " mismatches\n";
+
+    for (bool const mixed : {true, false}) {
+        if (!benchmark(sample(count, seed, mixed))) {
+            std::cerr << "sums differ\n";
+            failures += 1;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <mapped_file.hpp>
+
+/**
+ * A minimal log processor: counts the lines of a file, and the lines containing a pattern.
+ *
+ * The usual way reads each line with std::getline() into a std::string - copying every byte once
+ * more, and allocating whenever a line doesn't fit the string's capacity. With mapped_file (see
+ * include/mapped_file.hpp) each line is a std::string_view into the mapped file instead, and all
+ * the processing - find(), remove_prefix(), ... - works on that view without copying.
+ *
+ * Both ways are timed for a file; "-" reads standard input (e.g. a pipe) with mapped_file only,
+ * which then reads it in chunks.
+ */
+
+struct Counts {
+    std::size_t lines{0};
+    std::size_t bytes{0};
+    std::size_t matches{0};
+};
+
+// The message of a line "<timestamp> <level> <message>" - or the whole line, without both.
+std::string_view message(std::string_view line)
+{
+    for (int field{0}; field < 2; ++field) {
+        auto const space = line.find(' ');
+        if (space == line.npos) {
+            return line;
+        }
+        line.remove_prefix(space + 1);
+    }
+    return line;
+}
+
+void count(std::string_view line, std::string_view pattern, Counts& counts)
+{
+    ++counts.lines;
+    counts.bytes += line.size();
+    if (!pattern.empty() && message(line).find(pattern) != std::string_view::npos) {
+        ++counts.matches;
+    }
+}
+
+Counts with_getline(char const* path, std::string_view pattern)
+{
+    Counts counts;
+    std::ifstream in{path};
+    for (std::string line; std::getline(in, line);) {
+        count(line, pattern, counts);
+    }
+    return counts;
+}
+
+Counts with_mapped_file(char const* path, std::string_view pattern)
+{
+    Counts counts;
+    mapped_file file{path};
+    for (auto const line : file.lines()) {
+        count(line, pattern, counts);
+    }
+    if (file.error()) {
+        throw std::filesystem::filesystem_error{"read", path, file.error()};
+    }
+    return counts;
+}
+
+template <typename F>
+void run(char const* name, F&& f)
+{
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    auto const counts = f();
+    duration<double, std::milli> const elapsed{steady_clock::now() - start};
+    std::cout << name << ": " << counts.lines << " lines, " << counts.bytes << " bytes, "
+              << counts.matches << " matches, " << elapsed.count() << " ms\n";
+}
+
+int main(int argc, char* argv[])
+{
+    char const* pattern{""};
+    char const* path{nullptr};
+    for (int i{1}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--pattern") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        }
+        else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        std::cerr << "Usage: " << argv[0] << " [--pattern <text>] <file>|-\n";
+        return EXIT_FAILURE;
+    }
+    try {
+        if (std::strcmp(path, "-") != 0) {
+            run("std::getline", [&] { return with_getline(path, pattern); });
+        }
+        run("mapped_file  ", [&] { return with_mapped_file(path, pattern); });
+    }
+    catch (std::exception const& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,203 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <track_new.hpp>
+#include "tokenizer.hpp"
+
+/**
+ * Checks tokens::tokenizer (see tokenizer.hpp) on the edge cases of splitting, and compares it
+ * with splitting by std::getline() from std::stringstreams on a log of comma separated lines -
+ * the time, and the allocations counted by track_new.hpp.
+ *
+ *     split_check [--lines <n>]
+ */
+
+struct Case {
+    std::string_view text;
+    std::vector<std::string_view> expected;
+};
+
+template <typename Delimiter>
+bool check(Delimiter delimiter, tokens::Options opts, std::vector<Case> const& cases)
+{
+    bool ok{true};
+    for (auto const& c : cases) {
+        std::vector<std::string_view> actual;
+        for (auto const token : tokens::tokenizer{c.text, delimiter, opts}) {
+            actual.push_back(token);
+        }
+        if (actual != c.expected) {
+            std::cerr << "MISMATCH for \"" << c.text << "\":";
+            for (auto const token : actual) {
+                std::cerr << " [" << token << ']';
+            }
+            std::cerr << '\n';
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool check_all()
+{
+    // long enough for the 16 byte steps of SSE2
+    constexpr std::string_view long_text{"0123456789abcdefghijklmnopqrstuvwxyz,0123456789abcdefg"};
+    bool ok = check(',', {}, {
+        {"", {}},
+        {"a", {"a"}},
+        {"a,b,c", {"a", "b", "c"}},
+        {"a,,b,", {"a", "", "b", ""}},
+        {",", {"", ""}},
+        {long_text, {long_text.substr(0, 36), long_text.substr(37)}},
+    });
+    ok = check(',', {'\0', '\0', true}, {
+        {",a,,b,", {"a", "b"}},
+        {",,", {}},
+    }) && ok;
+    ok = check(std::string_view{"::"}, {}, {
+        {"a::b:c::", {"a", "b:c", ""}},
+        {"a:::b", {"a", ":b"}},
+        {"::", {"", ""}},
+    }) && ok;
+    ok = check(tokens::any_of{" \t"}, {'\0', '\0', true}, {
+        {"  one\ttwo  three ", {"one", "two", "three"}},
+    }) && ok;
+    ok = check(tokens::any_of{" \t\n;:="}, {}, {
+        {"k=v;x:y z", {"k", "v", "x", "y", "z"}},
+        {"0123456789abcdefghij=0123456789abcdefghij",
+         {"0123456789abcdefghij", "0123456789abcdefghij"}},
+    }) && ok;
+    ok = check(',', {'"', '\\', false}, {
+        {R"("a,b",c)", {"a,b", "c"}},
+        {R"("a\",b",c)", {R"(a\",b)", "c"}},
+        {R"(a\,b,c)", {R"(a\,b)", "c"}},
+        {R"(x"y,z)", {R"(x"y)", "z"}},
+        {R"("ab"cd,e)", {"ab", "e"}},
+        {R"("open,end)", {"open,end"}},
+        {R"(a,"")", {"a", ""}},
+    }) && ok;
+    ok = check(',', {'"', '"', false}, {
+        {R"("say ""hi""",x""y)", {R"(say ""hi"")", R"(x""y)"}},
+    }) && ok;
+
+    std::string unescaped;
+    tokens::unescape(R"(say ""hi"")", {'"', '"', false}, unescaped);
+    tokens::unescape(R"(|a\,b\\)", {'"', '\\', false}, unescaped);
+    if (unescaped != R"(say "hi"|a,b\)") {
+        std::cerr << "MISMATCH for unescape: " << unescaped << '\n';
+        ok = false;
+    }
+    return ok;
+}
+
+std::string log_text(std::size_t lines)
+{
+    static constexpr char const* levels[]{"INFO", "WARN", "DEBUG", "ERROR"};
+    static constexpr char const* messages[]{"request done", "cache miss", "retrying upstream",
+                                            "connection closed by peer"};
+    std::mt19937_64 rng{7};
+    std::string text;
+    for (std::size_t i{0}; i < lines; ++i) {
+        text += "2026-10-18T12:";
+        text += std::to_string(10 + rng() % 50);
+        text += ":00.";
+        text += std::to_string(100 + rng() % 900);
+        text += ',';
+        text += levels[rng() % 4];
+        text += ",worker-";
+        text += std::to_string(rng() % 64);
+        text += ',';
+        text += messages[rng() % 4];
+        text += ',';
+        text += std::to_string(rng() % 100'000);
+        text += '\n';
+    }
+    return text;
+}
+
+struct Totals {
+    std::size_t tokens{0};
+    std::size_t bytes{0};
+};
+
+template <typename F>
+Totals measure(char const* name, std::size_t lines, F&& split)
+{
+    using namespace std::chrono;
+    TrackNew::reset();
+    auto const start = steady_clock::now();
+    auto const totals = split();
+    duration<double> const elapsed{steady_clock::now() - start};
+    std::cout << std::left << std::setw(30) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << elapsed.count() * 1000 << " ms "
+              << std::setw(7) << static_cast<double>(lines) / elapsed.count() / 1e6
+              << " M lines/s  " << std::flush;
+    TrackNew::status();
+    return totals;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t lines{1'000'000};
+    for (int i{1}; i < argc; i += 2) {
+        if (std::strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--lines <n>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    bool ok = check_all();
+    std::cout << (ok ? "all cases split as expected\n" : "cases FAILED\n");
+
+    auto const text = log_text(lines);
+    auto const streamed = measure("stringstream + getline", lines, [&] {
+        Totals t;
+        std::istringstream in{text};
+        std::string line;
+        std::string field;
+        while (std::getline(in, line)) {
+            std::istringstream fields{line};
+            while (std::getline(fields, field, ',')) {
+                ++t.tokens;
+                t.bytes += field.size();
+            }
+        }
+        return t;
+    });
+    auto const viewed = measure("tokenizer", lines, [&] {
+        Totals t;
+        for (auto const line : tokens::tokenizer{text, '\n', {'\0', '\0', true}}) {
+            for (auto const field : tokens::tokenizer{line, ','}) {
+                ++t.tokens;
+                t.bytes += field.size();
+            }
+        }
+        return t;
+    });
+    measure("tokenizer, quotes and escapes", lines, [&] {
+        Totals t;
+        for (auto const line : tokens::tokenizer{text, '\n', {'\0', '\0', true}}) {
+            for (auto const field : tokens::tokenizer{line, ',', {'"', '\\', false}}) {
+                ++t.tokens;
+                t.bytes += field.size();
+            }
+        }
+        return t;
+    });
+    if (streamed.tokens != viewed.tokens || streamed.bytes != viewed.bytes) {
+        std::cerr << "token counts differ\n";
+        ok = false;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -7,6 +7,9 @@
 #include <type_traits>
 #include <utility>
 
+#include "as_int.hpp"
+#include "timestamp.hpp"
+
 /**
  * C++17 introduces std::string_view - a 'view' into a string - meaning that it's non-mutable,
  * string_view can not be used to write to the pointed-to data.
@@ -40,26 +43,16 @@
 // | remove_suffix()                 | Remove trailing characters                         |
 // | hash<>                          | Function object type to compute hash values        |
 
-// example usage of std::string_view
-std::optional<int> asInt(std::string_view sv)
-{
-    int val;
-    // read character sequence into the int:
-    auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), val);
-    // if we have an error code, return no value:
-    if (ec != std::errc{}) {
-        return std::nullopt;
-    }
-    return val;
-}
-
 std::string toString(std::string_view prefix, const std::chrono::system_clock::time_point& tp)
 {
-    auto rawtime = std::chrono::system_clock::to_time_t(tp);
-    std::string_view ts = std::ctime(&rawtime);  // NOTE: not thread safe
-    ts.remove_suffix(1);                         // skip trailing newline
+    // std::ctime() would do as well - but it's not thread safe, see timestamp.hpp
+    char ts[timestamp::max_size];
+    auto const r = timestamp::format(ts, ts + sizeof(ts), tp, 0);
+    char* const end = r.ec == std::errc{} ? r.ptr : ts;  // no local time: the prefix only
     // std::string(prefix) + ts;             // unfortunately no operator + yet
-    return std::string{prefix} + std::string{ts};
+    std::string s;
+    s.reserve(prefix.size() + static_cast<std::size_t>(end - ts));  // a single allocation
+    return s.append(prefix).append(ts, end);
 }
 
 // Rules for using std::string_view:
@@ -0,0 +1,115 @@
+#ifndef TIMESTAMP_HEADER_GUARD
+#define TIMESTAMP_HEADER_GUARD
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <system_error>
+
+/**
+ * Formats a std::chrono::system_clock::time_point as local time, "2026-10-18 20:43:12.123456",
+ * into a buffer of the caller - unlike std::ctime(), which returns a static buffer shared by all
+ * threads (so it's not thread safe), and whose result then gets copied into a std::string.
+ *
+ * Loggers format one timestamp per line, and most lines share their second with the line before.
+ * So each thread keeps the date and time up to the second it formatted last, as text: only when
+ * the second changes, the calendar is computed (with the thread safe localtime_r()) and the text
+ * rendered again. Otherwise it's copied, and only the fraction of the second is written, with
+ * std::to_chars.
+ */
+
+namespace timestamp {
+
+// "YYYY-MM-DD hh:mm:ss" and up to 9 digits of the fraction: "2026-10-18 20:43:12.123456789".
+inline constexpr std::size_t seconds_size{19};
+inline constexpr std::size_t max_size{seconds_size + 10};
+
+namespace detail {
+
+inline char* two_digits(char* p, int value) noexcept
+{
+    *p++ = static_cast<char>('0' + value / 10);
+    *p++ = static_cast<char>('0' + value % 10);
+    return p;
+}
+
+// The local time of `t`, to the second - computed only if it's another second than before.
+// Null if there's no calendar time for `t` (e.g. before 1970 on Windows), or its year doesn't
+// have four digits.
+inline char const* seconds_text(std::time_t t) noexcept
+{
+    struct Cache {
+        std::time_t second{std::numeric_limits<std::time_t>::min()};
+        char text[seconds_size]{};
+    };
+    thread_local Cache cache;
+    if (t == cache.second) {
+        return cache.text;
+    }
+    std::tm tm{};
+#if defined(_WIN32)
+    bool const converted = localtime_s(&tm, &t) == 0;
+#else
+    bool const converted = localtime_r(&t, &tm) != nullptr;
+#endif
+    if (!converted || tm.tm_year < -1900 || tm.tm_year > 9999 - 1900) {
+        return nullptr;     // and the cache is kept
+    }
+    char* p = cache.text;
+    auto const year = tm.tm_year + 1900;
+    p = two_digits(p, year / 100 % 100);
+    p = two_digits(p, year % 100);
+    *p++ = '-';
+    p = two_digits(p, tm.tm_mon + 1);
+    *p++ = '-';
+    p = two_digits(p, tm.tm_mday);
+    *p++ = ' ';
+    p = two_digits(p, tm.tm_hour);
+    *p++ = ':';
+    p = two_digits(p, tm.tm_min);
+    *p++ = ':';
+    two_digits(p, tm.tm_sec);
+    cache.second = t;
+    return cache.text;
+}
+
+} // namespace detail
+
+// Writes `tp` with `digits` (0 to 9) digits of the fraction of the second into [first, last), like
+// std::to_chars: returns {past the end, {}}, or {last, value_too_large} if it doesn't fit - or if
+// `tp` has no local time with a four digit year.
+inline std::to_chars_result format(char* first, char* last,
+                                   std::chrono::system_clock::time_point tp,
+                                   int digits = 6) noexcept
+{
+    using namespace std::chrono;
+    digits = digits < 0 ? 0 : digits > 9 ? 9 : digits;
+    auto const size = seconds_size + (digits != 0 ? 1 + static_cast<std::size_t>(digits) : 0);
+    if (static_cast<std::size_t>(last - first) < size) {
+        return {last, std::errc::value_too_large};
+    }
+    auto const second = floor<seconds>(tp);     // also before 1970: the fraction is positive
+    auto const* const text = detail::seconds_text(system_clock::to_time_t(second));
+    if (!text) {
+        return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, text, seconds_size);
+    auto* p = first + seconds_size;
+    if (digits == 0) {
+        return {p, std::errc{}};
+    }
+    constexpr std::int64_t pow10[]{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                                   100000000, 1000000000};
+    auto const fraction = duration_cast<nanoseconds>(tp - second).count() / pow10[9 - digits];
+    // zero-padded: with a leading 1, which is then overwritten by the '.'
+    std::to_chars(p, p + 1 + digits, fraction + pow10[digits]);
+    *p++ = '.';
+    return {p + digits, std::errc{}};
+}
+
+} // namespace timestamp
+
+#endif // TIMESTAMP_HEADER_GUARD
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "timestamp.hpp"
+
+/**
+ * Checks timestamp::format() (see timestamp.hpp) against std::strftime() for random time points,
+ * from many threads at once, and measures it for a logger's pattern - many timestamps per second
+ * - against std::ctime() with a prefix concatenated to std::strings.
+ *
+ *     timestamp_check [--count <n>] [--threads <n>]
+ */
+
+using clock_type = std::chrono::system_clock;
+
+// The expected text: strftime() of localtime_r(), and the fraction with iostreams.
+std::string expected(clock_type::time_point tp, int digits)
+{
+    using namespace std::chrono;
+    auto const second = floor<seconds>(tp);
+    auto const t = clock_type::to_time_t(second);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char text[64];
+    std::string s(text, std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm));
+    if (digits != 0) {
+        auto fraction = duration_cast<nanoseconds>(tp - second).count();
+        for (int i{digits}; i < 9; ++i) {
+            fraction /= 10;
+        }
+        std::ostringstream out;
+        out << '.' << std::setw(digits) << std::setfill('0') << fraction;
+        s += out.str();
+    }
+    return s;
+}
+
+// Formats random time points - mostly within the same second as the one before, to use the cache
+// - and compares them with expected().
+std::size_t mismatches(std::uint64_t seed, std::size_t count)
+{
+    std::mt19937_64 rng{seed};
+    // 1900 to 2100
+    std::uniform_int_distribution<std::int64_t> seconds{-2'208'988'800, 4'102'444'800};
+    std::uniform_int_distribution<std::int64_t> nanos{0, 999'999'999};
+    std::size_t failures{0};
+    clock_type::time_point tp{};
+    for (std::size_t i{0}; i < count; ++i) {
+        if (i % 16 == 0) {
+            tp = clock_type::time_point{std::chrono::seconds{seconds(rng)}};
+        }
+        auto const at = tp + std::chrono::duration_cast<clock_type::duration>(
+                                 std::chrono::nanoseconds{nanos(rng)});
+        auto const digits = static_cast<int>(rng() % 10);
+        char text[timestamp::max_size];
+        auto const r = timestamp::format(text, text + sizeof(text), at, digits);
+        if (r.ec != std::errc{} || std::string_view(text, static_cast<std::size_t>(r.ptr - text))
+                                       != expected(at, digits)) {
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+template <typename F>
+void measure(char const* name, std::size_t count, F&& f)
+{
+    using namespace std::chrono;
+    auto const start = steady_clock::now();
+    auto const bytes = f();
+    duration<double> const elapsed{steady_clock::now() - start};
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << elapsed.count() * 1000 << " ms "
+              << std::setw(7) << static_cast<double>(count) / elapsed.count() / 1e6
+              << " M timestamps/s (" << bytes << " bytes)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count{2'000'000};
+    std::size_t threads{4};
+    for (int i{1}; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--count") == 0) {
+            count = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0) {
+            threads = std::max<std::size_t>(std::strtoull(argv[i + 1], nullptr, 10), 1);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--count <n>] [--threads <n>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // each thread with its own cache, all at the same time
+    std::vector<std::size_t> failures(threads);
+    std::vector<std::thread> workers;
+    for (std::size_t t{0}; t < threads; ++t) {
+        workers.emplace_back([&failures, t] { failures[t] = mismatches(t + 1, 200'000); });
+    }
+    std::size_t failed{0};
+    for (std::size_t t{0}; t < threads; ++t) {
+        workers[t].join();
+        failed += failures[t];
+    }
+    std::cout << threads * 200'000 << " time points in " << threads << " threads, " << failed
+              << " mismatches\n";
+
+    // a log line's worth of timestamps every microsecond
+    auto const start = clock_type::now();
+    auto const at = [start](std::size_t i) {
+        return start + std::chrono::duration_cast<clock_type::duration>(
+                           std::chrono::microseconds{i});
+    };
+    constexpr std::string_view prefix{"[worker-7] "};
+    measure("ctime + std::string", count, [&] {
+        std::size_t bytes{0};
+        for (std::size_t i{0}; i < count; ++i) {
+            auto const t = clock_type::to_time_t(at(i));
+            std::string_view ts = std::ctime(&t);
+            ts.remove_suffix(1);
+            bytes += (std::string{prefix} + std::string{ts}).size();
+        }
+        return bytes;
+    });
+    measure("timestamp::format, micros", count, [&] {
+        std::size_t bytes{0};
+        char line[128];
+        std::memcpy(line, prefix.data(), prefix.size());
+        for (std::size_t i{0}; i < count; ++i) {
+            auto* const first = line + prefix.size();
+            bytes += static_cast<std::size_t>(
+                timestamp::format(first, std::end(line), at(i)).ptr - line);
+        }
+        return bytes;
+    });
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
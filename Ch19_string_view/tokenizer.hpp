@@ -0,0 +1,323 @@
+#ifndef TOKENIZER_HEADER_GUARD
+#define TOKENIZER_HEADER_GUARD
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Splits a std::string_view into tokens, which are std::string_views into the same text - found
+ * one by one while iterating, without a copy or an allocation. That's the difference to splitting
+ * with std::getline() from a std::stringstream: it copies the text into the stream, and each
+ * token once more into a std::string.
+ *
+ *     for (auto field : tokens::tokenizer{line, ','}) ...                 // one character
+ *     for (auto field : tokens::tokenizer{line, "::"}) ...                // a string
+ *     for (auto word : tokens::tokenizer{line, tokens::any_of{" \t"}, {'\0', '\0', true}}) ...
+ *
+ * The delimiter is one character, a string, or any character of a set. n delimiters separate n + 1
+ * tokens - "a,,b," is "a", "", "b", "" - unless Options::skip_empty drops the empty ones (e.g. to
+ * split on runs of whitespace). An empty text has no tokens.
+ *
+ * With Options::quote, a token which starts with the quote character ends at the matching quote,
+ * and delimiters in between are part of it; the token is what's between the quotes (anything
+ * after the closing quote, up to the delimiter, is dropped). With Options::escape, the character
+ * after the escape character never ends a token or a quote. A quote inside a quoted token can
+ * also be written twice, as in CSV, if the escape character is the quote (outside of quotes it's
+ * then just a character). Since the tokens are views, escapes are kept as they are - unescape()
+ * resolves them, into a string.
+ *
+ * The search for the next delimiter (or quote or escape) is std::memchr() for a single character,
+ * compares 16 bytes at a time with SSE2 for up to 4 characters, and looks each byte up in a table
+ * for more.
+ */
+
+namespace tokens {
+
+struct Options {
+    char quote{'\0'};           // '\0': no quoting
+    char escape{'\0'};          // '\0': no escapes
+    bool skip_empty{false};
+};
+
+// Any of `chars` is a delimiter.
+struct any_of {
+    std::string_view chars;
+};
+
+namespace detail {
+
+// Finds the first of a set of characters.
+class Finder
+{
+public:
+    Finder() = default;
+
+    void add(char c) noexcept
+    {
+        auto const u = static_cast<unsigned char>(c);
+        if (table_[u / 64] & (std::uint64_t{1} << (u % 64))) {
+            return;
+        }
+        table_[u / 64] |= std::uint64_t{1} << (u % 64);
+        if (count_ < chars_.size()) {
+            chars_[count_] = c;
+        }
+        ++count_;
+    }
+
+    bool contains(char c) const noexcept
+    {
+        auto const u = static_cast<unsigned char>(c);
+        return (table_[u / 64] >> (u % 64)) & 1;
+    }
+
+    // The first of [p, last) in the set, or `last`.
+    char const* find(char const* p, char const* last) const noexcept
+    {
+        if (count_ == 1) {
+            auto const* const hit = std::memchr(p, chars_[0], static_cast<std::size_t>(last - p));
+            return hit ? static_cast<char const*>(hit) : last;
+        }
+#if defined(__SSE2__)
+        if (count_ <= chars_.size()) {
+            // unused slots repeat the first character
+            auto const v0 = _mm_set1_epi8(chars_[0]);
+            auto const v1 = _mm_set1_epi8(count_ > 1 ? chars_[1] : chars_[0]);
+            auto const v2 = _mm_set1_epi8(count_ > 2 ? chars_[2] : chars_[0]);
+            auto const v3 = _mm_set1_epi8(count_ > 3 ? chars_[3] : chars_[0]);
+            for (; last - p >= 16; p += 16) {
+                auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+                auto const hits = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, v0), _mm_cmpeq_epi8(v, v1)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, v2), _mm_cmpeq_epi8(v, v3)));
+                if (auto const mask = _mm_movemask_epi8(hits)) {
+                    return p + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+            }
+        }
+#endif
+        while (p != last && !contains(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+private:
+    std::array<std::uint64_t, 4> table_{};      // a bit per byte value
+    std::array<char, 4> chars_{};               // the first few, for memchr or SSE2
+    std::size_t count_{0};
+};
+
+} // namespace detail
+
+class tokenizer
+{
+public:
+    class iterator;
+
+    tokenizer(std::string_view text, char delimiter, Options opts = {}) noexcept
+        : tokenizer{text, opts}
+    {
+        delimiter_.add(delimiter);
+        special_.add(delimiter);
+    }
+
+    // An empty delimiter string makes the whole text one token.
+    tokenizer(std::string_view text, std::string_view delimiter, Options opts = {}) noexcept
+        : tokenizer{text, opts}
+    {
+        string_ = delimiter;
+        if (!delimiter.empty()) {
+            delimiter_.add(delimiter.front());
+            special_.add(delimiter.front());
+        }
+    }
+
+    tokenizer(std::string_view text, any_of delimiters, Options opts = {}) noexcept
+        : tokenizer{text, opts}
+    {
+        for (auto const c : delimiters.chars) {
+            delimiter_.add(c);
+            special_.add(c);
+        }
+    }
+
+    iterator begin() noexcept;
+    iterator end() noexcept;
+
+    // The next token, false at the end.
+    bool next(std::string_view& token) noexcept
+    {
+        while (!done_) {
+            token = scan();
+            if (!opts_.skip_empty || !token.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    tokenizer(std::string_view text, Options opts) noexcept
+        : p_{text.data()}, last_{text.data() + text.size()}, done_{text.empty()}, opts_{opts}
+    {
+        for (auto const c : {opts.quote, opts.escape}) {
+            if (c != '\0') {
+                special_.add(c);
+                quoted_.add(c);
+            }
+        }
+    }
+
+    std::string_view scan() noexcept
+    {
+        auto const* const start = p_;
+        if (opts_.quote != '\0' && p_ != last_ && *p_ == opts_.quote) {
+            auto const* const close = closing_quote(p_ + 1);
+            if (close == last_) {
+                done_ = true;       // unterminated, the rest is the token
+                p_ = last_;
+                return view(start + 1, last_);
+            }
+            advance(delimiter(close + 1));
+            return view(start + 1, close);
+        }
+        auto const* const end = delimiter(p_);
+        advance(end);
+        return view(start, end);
+    }
+
+    // The closing quote at or after `p`, or `last_`.
+    char const* closing_quote(char const* p) const noexcept
+    {
+        for (;;) {
+            p = quoted_.find(p, last_);
+            if (p == last_) {
+                return p;
+            }
+            bool const doubled = *p == opts_.quote && opts_.escape == opts_.quote;
+            if (*p == opts_.quote && !(doubled && last_ - p > 1 && p[1] == opts_.quote)) {
+                return p;
+            }
+            p = last_ - p > 1 ? p + 2 : last_;      // escaped, or a doubled quote
+        }
+    }
+
+    // The next delimiter at or after `p`, or `last_`.
+    char const* delimiter(char const* p) const noexcept
+    {
+        for (;;) {
+            p = special_.find(p, last_);
+            if (p == last_) {
+                return p;
+            }
+            if (*p == opts_.escape && opts_.escape != '\0' && opts_.escape != opts_.quote) {
+                p = last_ - p > 1 ? p + 2 : last_;
+            }
+            else if (!delimiter_.contains(*p)) {
+                ++p;    // a quote inside a token is just a character
+            }
+            else if (string_.empty()
+                     || (static_cast<std::size_t>(last_ - p) >= string_.size()
+                         && std::memcmp(p, string_.data(), string_.size()) == 0)) {
+                return p;
+            }
+            else {
+                ++p;
+            }
+        }
+    }
+
+    // Continues after the delimiter at `p` - or ends at `last_`.
+    void advance(char const* p) noexcept
+    {
+        if (p == last_) {
+            done_ = true;
+        }
+        p_ = p == last_ ? last_ : p + (string_.empty() ? 1 : string_.size());
+    }
+
+    static std::string_view view(char const* first, char const* last) noexcept
+    {
+        return {first, static_cast<std::size_t>(last - first)};
+    }
+
+    char const* p_;
+    char const* last_;
+    bool done_;
+    Options opts_;
+    std::string_view string_{};         // a delimiter string
+    detail::Finder delimiter_{};        // delimiter characters (of a string: the first)
+    detail::Finder special_{};          // delimiters, quote and escape
+    detail::Finder quoted_{};           // quote and escape
+};
+
+// An input iterator: all copies share the position of the tokenizer.
+class tokenizer::iterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::string_view const*;
+    using reference = std::string_view const&;
+
+    iterator() = default;
+    explicit iterator(tokenizer* t) noexcept : tokenizer_{t} { ++*this; }
+
+    reference operator*() const noexcept { return token_; }
+    pointer operator->() const noexcept { return &token_; }
+
+    iterator& operator++() noexcept
+    {
+        if (!tokenizer_->next(token_)) {
+            tokenizer_ = nullptr;
+        }
+        return *this;
+    }
+
+    iterator operator++(int) noexcept
+    {
+        auto const old = *this;
+        ++*this;
+        return old;
+    }
+
+    friend bool operator==(iterator const& a, iterator const& b) noexcept
+    {
+        return a.tokenizer_ == b.tokenizer_;
+    }
+    friend bool operator!=(iterator const& a, iterator const& b) noexcept { return !(a == b); }
+
+private:
+    tokenizer* tokenizer_{nullptr};
+    std::string_view token_{};
+};
+
+inline tokenizer::iterator tokenizer::begin() noexcept { return iterator{this}; }
+inline tokenizer::iterator tokenizer::end() noexcept { return iterator{}; }
+
+// Appends `token` to `out` with its escapes resolved - which also turns doubled quotes into one if
+// the quote is the escape character.
+inline void unescape(std::string_view token, Options const& opts, std::string& out)
+{
+    for (std::size_t i{0}; i < token.size(); ++i) {
+        if (token[i] == opts.escape && opts.escape != '\0' && i + 1 < token.size()) {
+            ++i;
+        }
+        out += token[i];
+    }
+}
+
+} // namespace tokens
+
+#endif // TOKENIZER_HEADER_GUARD
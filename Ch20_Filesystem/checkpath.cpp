@@ -1,32 +1,72 @@
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <string>
 
+#include "path_batch.hpp"
+#include "scan.hpp"
 
 int main(int argc, char* argv[])
 {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path>\n";
+    // --batch <file>: classify the paths listed in <file> (or stdin for "-"), one per line or
+    // NUL-separated with -0, see path_batch.hpp
+    auto const usage = [argv] {
+        std::cerr << "Usage: " << argv[0] << " <path>\n"
+                  << "       " << argv[0] << " --batch <file>|- [-0] [--threads <n>]\n";
         return EXIT_FAILURE;
+    };
+    if (argc >= 3 && std::strcmp(argv[1], "--batch") == 0) {
+        batch::Options opts;
+        for (int i{3}; i < argc; ++i) {
+            if (std::strcmp(argv[i], "-0") == 0) {
+                opts.separator = '\0';
+            }
+            else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                opts.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+            }
+            else {
+                return usage();
+            }
+        }
+        return batch::run(argv[2], opts);
+    }
+    if (argc != 2 || argv[1][0] == '-') {
+        return usage();
     }
 
     std::filesystem::path p{argv[1]};  // filesystem path, might not exist
-    if (std::filesystem::is_regular_file(p)) {
-        std::cout << "\"" << p << "\" is a file with " << std::filesystem::file_size(p)
-                  << " bytes\n";
+    // Each of the free functions is_regular_file(p), file_size(p), is_directory(p) and exists(p)
+    // would stat() the path again - scan::stat() gets type and size with a single call instead.
+    std::error_code ec;
+    auto const st = scan::stat(p, scan::field::type | scan::field::size | scan::field::follow, ec);
+    if (st.type == std::filesystem::file_type::regular) {
+        std::cout << "\"" << p << "\" is a file with " << st.size << " bytes\n";
     }
-    else if (is_directory(p)) { // ADL - could have also been used above,
+    else if (st.type == std::filesystem::file_type::directory) {
         std::cout << "\"" << p << "\" is a directory containing:\n";
-        for (auto& e : std::filesystem::directory_iterator{p}) {
-            // using .path().string() prevents automatically quoting and escaping backslashes
-            // when printing the path:
-            std::cout << " \"" << e.path().string() << "\"\n";
+        // the entry names come straight from readdir(), no stat() per entry
+        auto const dir = scan::Directory::open(p, ec);
+        if (dir) {
+            ec = dir.for_each(0, [&p](scan::Entry const& e) {
+                // using .string() prevents automatically quoting and escaping backslashes
+                // when printing the path:
+                std::cout << " \"" << (p / e.name).string() << "\"\n";
+            });
+        }
+        if (ec) {
+            std::cerr << "error reading \"" << p.string() << "\": " << ec.message() << "\n";
         }
     }
-    else if (exists(p)) {
-        std::cout << "\"" << p << "\" exists, is a special file\n";
+    else if (st.type == std::filesystem::file_type::not_found) {
+        std::cout << "path \"" << p << "\" does not exist\n";
+    }
+    else if (ec) {
+        // e.g. a symlink loop, or no permission to search a directory on the way
+        std::cerr << "error checking \"" << p.string() << "\": " << ec.message() << "\n";
+        return EXIT_FAILURE;
     }
     else {
-        std::cout << "path \"" << p << "\" does not exist\n";
+        std::cout << "\"" << p << "\" exists, is a special file\n";
     }
 }
@@ -1,33 +1,120 @@
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <vector>
+
+#include "metadata.hpp"
+#include "path_batch.hpp"
 
 namespace fs = std::filesystem;
 
+// Checks all paths given on the command line. The paths are stat()ed in one batch, the
+// directories among them opened in one batch, and the entries of each directory stat()ed in one
+// batch - with --backend uring these batches are submitted to io_uring (see metadata.hpp).
+// With --batch the paths are read from a file instead (see path_batch.hpp).
 int main(int argc, char* argv[])
 {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path> \n";
+    auto const usage = [argv] {
+        std::cerr << "Usage: " << argv[0] << " [--backend sync|uring] <path>... \n"
+                  << "       " << argv[0]
+                  << " [--backend sync|uring] --batch <file>|- [-0] [--threads <n>]\n";
         return EXIT_FAILURE;
+    };
+    scan::Backend backend{scan::Backend::sync};
+    int first{1};
+    if (argc > 2 && std::strcmp(argv[1], "--backend") == 0) {
+        if (std::strcmp(argv[2], "uring") == 0) {
+            backend = scan::Backend::uring;
+        }
+        else if (std::strcmp(argv[2], "sync") != 0) {
+            return usage();
+        }
+        first = 3;
+    }
+    // --batch <file>: classify the paths listed in <file> (or stdin for "-"), see path_batch.hpp
+    if (argc > first + 1 && std::strcmp(argv[first], "--batch") == 0) {
+        batch::Options opts;
+        opts.backend = backend;
+        for (int i{first + 2}; i < argc; ++i) {
+            if (std::strcmp(argv[i], "-0") == 0) {
+                opts.separator = '\0';
+            }
+            else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                opts.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+            }
+            else {
+                return usage();
+            }
+        }
+        return batch::run(argv[first + 1], opts);
+    }
+    // no more options - the paths follow
+    if (argc <= first || std::any_of(argv + first, argv + argc,
+                                     [](char const* arg) { return arg[0] == '-'; })) {
+        return usage();
     }
 
-    // instead of chaining if-else statements we can directly query and switch on the type of
-    // fs::path:
-    switch (fs::path p{argv[1]}; status(p).type()) {
-    case fs::file_type::not_found:
-        std::cerr << "path \"" << p.string() << "\" does not exist\n";
-        break;
-    case fs::file_type::regular:
-        std::cerr << '"' << p.string() << "\" is a regular file, size = " << file_size(p)
-                  << " bytes\n";
-        break;
-    case fs::file_type::directory:
-        std::cerr << '"' << p.string() << "\" is a directory containing:\n";
-        for (auto& e : std::filesystem::directory_iterator{p}) {
-            std::cerr << " " << e.path().string() << '\n';
+    scan::Metadata metadata{backend};
+    std::vector<fs::path> paths(argv + first, argv + argc);
+    std::vector<scan::StatRequest> stats(paths.size());
+    for (std::size_t i{0}; i < paths.size(); ++i) {
+        stats[i].name = paths[i].c_str();
+        stats[i].fields = scan::field::type | scan::field::size | scan::field::follow;
+    }
+    metadata.stat(stats.data(), stats.size());
+
+    std::vector<scan::OpenRequest> opens;
+    for (std::size_t i{0}; i < paths.size(); ++i) {
+        if (stats[i].entry.type == fs::file_type::directory) {
+            opens.emplace_back().path = &paths[i];
+        }
+    }
+    metadata.open(opens.data(), opens.size());
+
+    auto dir = opens.begin();
+    for (std::size_t i{0}; i < paths.size(); ++i) {
+        // instead of chaining if-else statements we can directly query and switch on the type of
+        // fs::path:
+        switch (auto const& p = paths[i]; stats[i].entry.type) {
+        case fs::file_type::not_found:
+            std::cerr << "path \"" << p.string() << "\" does not exist\n";
+            break;
+        case fs::file_type::regular:
+            std::cerr << '"' << p.string() << "\" is a regular file, size = "
+                      << stats[i].entry.size << " bytes\n";
+            break;
+        case fs::file_type::directory: {
+            std::cerr << '"' << p.string() << "\" is a directory containing:\n";
+            auto ec = dir->ec;
+            if (dir->dir) {
+                unsigned const fields{scan::field::type | scan::field::size};
+                ec = metadata.for_each(dir->dir, fields, [&p](scan::Entry const& e) {
+                    std::cerr << " " << (p / e.name).string();
+                    if (e.type == fs::file_type::directory) {
+                        std::cerr << '/';
+                    }
+                    else if (e.type == fs::file_type::regular) {
+                        std::cerr << " (" << e.size << " bytes)";
+                    }
+                    std::cerr << '\n';
+                });
+            }
+            if (ec) {
+                std::cerr << "error reading \"" << p.string() << "\": " << ec.message() << '\n';
+            }
+            ++dir;
+            break;
+        }
+        default:
+            if (stats[i].ec && stats[i].entry.type == fs::file_type::unknown) {
+                std::cerr << "error checking \"" << p.string() << "\": "
+                          << stats[i].ec.message() << '\n';
+            }
+            else {
+                std::cerr << '"' << p.string() << "\" is a special file\n";
+            }
+            break;
         }
-        break;
-    default:
-        std::cerr << '"' << p.string() << "\" is a special file\n";
-        break;
     }
 }
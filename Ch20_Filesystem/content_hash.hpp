@@ -0,0 +1,254 @@
+#if !defined(CONTENT_HASH_H_)
+#define CONTENT_HASH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <system_error>
+
+#include "scan.hpp"
+
+#if defined(SCAN_POSIX)
+#include <sys/mman.h>
+#endif
+
+/**
+ * Fast, non-cryptographic hashing of file contents.
+ *
+ * `Hash64` is a streaming implementation of XXH64 - it processes 32 bytes per step in four
+ * independent lanes, which keeps the multipliers of a core busy, and runs at memory bandwidth.
+ * It's meant to find candidate duplicates, not to resist deliberate collisions.
+ *
+ * Equal hashes only make equal contents very likely - same_contents() confirms them byte by byte.
+ *
+ * hash_file() maps large files (and advises sequential access), so the hash reads straight from
+ * the page cache without copying; small files are read into a per-thread buffer. Like any reader
+ * of a mapping, it gets SIGBUS if a file is truncated while it's hashed - it's meant for trees at
+ * rest.
+ */
+
+namespace content {
+
+namespace fs = std::filesystem;
+
+class Hash64
+{
+public:
+    explicit Hash64(std::uint64_t seed = 0) noexcept
+        : lanes_{seed + p1 + p2, seed + p2, seed, seed - p1}, seed_{seed}
+    {
+    }
+
+    void update(void const* data, std::size_t size) noexcept
+    {
+        auto const* p = static_cast<unsigned char const*>(data);
+        auto const* const end = p + size;
+        total_ += size;
+        if (buffered_ + size < sizeof(buffer_)) {
+            std::memcpy(buffer_ + buffered_, p, size);
+            buffered_ += size;
+            return;
+        }
+        if (buffered_ != 0) {
+            auto const fill = sizeof(buffer_) - buffered_;
+            std::memcpy(buffer_ + buffered_, p, fill);
+            stripe(buffer_);
+            p += fill;
+            buffered_ = 0;
+        }
+        for (; end - p >= 32; p += 32) {
+            stripe(p);
+        }
+        buffered_ = static_cast<std::size_t>(end - p);
+        std::memcpy(buffer_, p, buffered_);
+    }
+
+    std::uint64_t digest() const noexcept
+    {
+        std::uint64_t h;
+        if (total_ >= 32) {
+            h = rotl(lanes_[0], 1) + rotl(lanes_[1], 7) + rotl(lanes_[2], 12) + rotl(lanes_[3], 18);
+            for (auto const lane : lanes_) {
+                h = (h ^ round(0, lane)) * p1 + p4;
+            }
+        }
+        else {
+            h = seed_ + p5;
+        }
+        h += total_;
+        unsigned char const* p = buffer_;
+        auto const* const end = buffer_ + buffered_;
+        for (; end - p >= 8; p += 8) {
+            h = rotl(h ^ round(0, read64(p)), 27) * p1 + p4;
+        }
+        if (end - p >= 4) {
+            h = rotl(h ^ (read32(p) * p1), 23) * p2 + p3;
+            p += 4;
+        }
+        for (; p != end; ++p) {
+            h = rotl(h ^ (*p * p5), 11) * p1;
+        }
+        h ^= h >> 33;
+        h *= p2;
+        h ^= h >> 29;
+        h *= p3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr std::uint64_t p1{11400714785074694791ull};
+    static constexpr std::uint64_t p2{14029467366897019727ull};
+    static constexpr std::uint64_t p3{1609587929392839161ull};
+    static constexpr std::uint64_t p4{9650029242287828579ull};
+    static constexpr std::uint64_t p5{2870177450012600261ull};
+
+    static std::uint64_t rotl(std::uint64_t x, int r) noexcept
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static std::uint64_t round(std::uint64_t acc, std::uint64_t input) noexcept
+    {
+        return rotl(acc + input * p2, 31) * p1;
+    }
+
+    // little endian hosts only - the hash value isn't stored anywhere
+    static std::uint64_t read64(unsigned char const* p) noexcept
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static std::uint64_t read32(unsigned char const* p) noexcept
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void stripe(unsigned char const* p) noexcept
+    {
+        for (int i{0}; i < 4; ++i) {
+            lanes_[i] = round(lanes_[i], read64(p + 8 * i));
+        }
+    }
+
+    std::uint64_t lanes_[4];
+    std::uint64_t seed_;
+    std::uint64_t total_{0};
+    unsigned char buffer_[32]{};
+    std::size_t buffered_{0};
+};
+
+// Hashes the first `limit` bytes of a file (all of it by default).
+inline std::uint64_t hash_file(fs::path const& path, std::error_code& ec,
+                               std::uint64_t limit = UINT64_MAX)
+{
+    constexpr std::size_t chunk{1 << 20};
+    Hash64 hash;
+    ec.clear();
+#if defined(SCAN_POSIX)
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ec.assign(errno, std::generic_category());
+        return 0;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ec.assign(errno, std::generic_category());
+        ::close(fd);
+        return 0;
+    }
+    auto const size = std::min(static_cast<std::uint64_t>(st.st_size), limit);
+    if (size >= chunk) {
+        void* const p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ::close(fd);
+            ::madvise(p, size, MADV_SEQUENTIAL);
+            hash.update(p, size);
+            ::munmap(p, size);
+            return hash.digest();
+        }
+    }
+    // small files (or no mapping possible): large reads into a buffer kept per thread
+    thread_local std::unique_ptr<char[]> buffer{new char[chunk]};
+    for (std::uint64_t left{size}; left != 0;) {
+        auto const n = ::read(fd, buffer.get(), std::min<std::uint64_t>(left, chunk));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {   // file shrank meanwhile - hash what's there
+            if (n < 0) {
+                ec.assign(errno, std::generic_category());
+            }
+            break;
+        }
+        hash.update(buffer.get(), static_cast<std::size_t>(n));
+        left -= static_cast<std::uint64_t>(n);
+    }
+    ::close(fd);
+#else
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return 0;
+    }
+    auto buffer = std::make_unique<char[]>(chunk);
+    for (std::uint64_t left{limit}; left != 0 && in;) {
+        in.read(buffer.get(), static_cast<std::streamsize>(std::min<std::uint64_t>(left, chunk)));
+        auto const n = static_cast<std::uint64_t>(in.gcount());
+        hash.update(buffer.get(), static_cast<std::size_t>(n));
+        left -= n;
+    }
+#endif
+    return hash.digest();
+}
+
+// Whether a file can be opened for reading.
+inline bool readable(fs::path const& path)
+{
+    return static_cast<bool>(std::ifstream{path, std::ios::binary});
+}
+
+// Whether two files have the same contents, compared byte by byte. Sets `ec` if either of them
+// can't be read.
+inline bool same_contents(fs::path const& a, fs::path const& b, std::error_code& ec)
+{
+    constexpr std::size_t chunk{1 << 20};
+    ec.clear();
+    std::ifstream in_a{a, std::ios::binary};
+    std::ifstream in_b{b, std::ios::binary};
+    if (!in_a || !in_b) {
+        ec = std::make_error_code(std::errc::no_such_file_or_directory);
+        return false;
+    }
+    // both chunks in one buffer kept per thread, like hash_file()
+    thread_local std::unique_ptr<char[]> buffer{new char[2 * chunk]};
+    auto* const buffer_a = buffer.get();
+    auto* const buffer_b = buffer.get() + chunk;
+    for (;;) {
+        in_a.read(buffer_a, chunk);
+        in_b.read(buffer_b, chunk);
+        if (in_a.bad() || in_b.bad()) {
+            ec = std::make_error_code(std::errc::io_error);
+            return false;
+        }
+        auto const n = in_a.gcount();
+        if (n != in_b.gcount()
+            || std::memcmp(buffer_a, buffer_b, static_cast<std::size_t>(n)) != 0) {
+            return false;
+        }
+        if (n < static_cast<std::streamsize>(chunk)) {
+            return true;    // both at their end
+        }
+    }
+}
+
+} // namespace content
+
+#endif // CONTENT_HASH_H_
@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <cstdlib>
 
+#include "visited_set.hpp"
+
 
 int main()
 {
@@ -32,10 +34,17 @@ int main()
         }
 
         // recursively list all files
+        // Following directory symlinks, a plain recursive_directory_iterator lists the contents
+        // of temp/test twice (once through slink), and never ends if a symlink points back up
+        // the tree - walk_unique() enters each directory only once.
         std::cout << fs::current_path().string() << ":\n";
         auto const iter_opts{fs::directory_options::follow_directory_symlink};
-        for (auto const& e : fs::recursive_directory_iterator{".", iter_opts}) {
+        std::error_code ec;
+        walk_unique(".", iter_opts, [](fs::directory_entry const& e) {
             std::cout << "  " << e.path().lexically_normal().string() << "\n";
+        }, ec);
+        if (ec) {
+            throw fs::filesystem_error{"cannot list", fs::path{"."}, ec};
         }
     }
     catch (fs::filesystem_error& e) {
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <per_thread.hpp>
+#include "content_hash.hpp"
+#include "parallel_for.hpp"
+#include "parallel_walk.hpp"
+
+/**
+ * Finds files with identical contents below a directory.
+ *
+ * Hashing every file is wasteful: only files of the same size can be equal. So the tree is
+ * walked once (in parallel, see parallel_walk.hpp) collecting size and inode of each regular file,
+ * and only files which share their size with another file are read at all:
+ * 1. group by size - hard links to the same inode count as one file,
+ * 2. hash the first 64 KiB of each candidate, and regroup by (size, prefix hash),
+ * 3. hash the remaining candidates completely (unless the prefix was the whole file),
+ * 4. compare the files of each group byte by byte - only files with the same contents are
+ *    reported as duplicates, however unlikely a collision of the 64 bit hashes is.
+ * Hashing and comparing run on a pool of threads, each taking the next file (or group) from a
+ * shared index.
+ */
+
+namespace fs = std::filesystem;
+
+struct File {
+    std::string path{};
+    std::uint64_t size{0};
+    std::uint64_t dev{0};
+    std::uint64_t ino{0};
+    std::uint64_t hash{0};
+    std::uint64_t variant{0};   // within the files of equal (size, hash), by their contents
+};
+
+// Keeps only the files which have at least one equal peer by (size, hash, variant), grouped
+// together.
+void keep_groups(std::vector<File>& files)
+{
+    // largest files first
+    std::sort(files.begin(), files.end(), [](File const& a, File const& b) {
+        return std::tie(b.size, a.hash, a.variant, a.path)
+               < std::tie(a.size, b.hash, b.variant, b.path);
+    });
+    auto const same = [](File const& a, File const& b) {
+        return a.size == b.size && a.hash == b.hash && a.variant == b.variant;
+    };
+    std::vector<File> kept;
+    for (auto first = files.begin(); first != files.end();) {
+        auto last = std::find_if_not(first + 1, files.end(),
+                                     [&](File const& f) { return same(*first, f); });
+        if (last - first > 1) {
+            std::move(first, last, std::back_inserter(kept));
+        }
+        first = last;
+    }
+    files = std::move(kept);
+}
+
+// Hashes the first `limit` bytes of all files in parallel; files which can't be read are dropped.
+void hash_all(std::vector<File>& files, std::uint64_t limit, std::size_t threads)
+{
+    parallel_for_index(files.size(), threads, [&](std::size_t i) {
+        std::error_code ec;
+        files[i].hash = content::hash_file(files[i].path, ec, limit);
+        if (ec) {
+            files[i].path.clear();
+        }
+    });
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [](File const& f) { return f.path.empty(); }),
+                files.end());
+}
+
+// Splits each group of files with equal (size, hash) into variants of byte for byte identical
+// contents - one group, almost always. Files which can't be read are dropped: the file compared
+// is checked first, and if a comparison fails nonetheless and the variant's first file can't be
+// read anymore, the next file of that variant takes its place.
+void confirm_groups(std::vector<File>& files, std::size_t threads)
+{
+    std::vector<std::pair<std::size_t, std::size_t>> groups;    // [first, last) of `files`
+    for (std::size_t first{0}, last{0}; first < files.size(); first = last) {
+        for (last = first + 1; last < files.size() && files[last].size == files[first].size
+                               && files[last].hash == files[first].hash;
+             ++last) {
+        }
+        groups.emplace_back(first, last);
+    }
+    parallel_for_index(groups.size(), threads, [&](std::size_t g) {
+        struct Variant {
+            std::size_t first;  // file compared with
+            std::uint64_t id;
+        };
+        std::vector<Variant> variants;
+        // another readable file of variant v before `end` as its first - or none, drop it
+        auto const replace = [&](std::size_t v, std::size_t end) {
+            files[variants[v].first].path.clear();
+            for (auto j = variants[v].first + 1; j < end; ++j) {
+                if (files[j].variant == variants[v].id && !files[j].path.empty()
+                    && content::readable(files[j].path)) {
+                    variants[v].first = j;
+                    return;
+                }
+            }
+            variants.erase(variants.begin() + static_cast<std::ptrdiff_t>(v));
+        };
+        std::uint64_t next_id{0};
+        for (auto i = groups[g].first; i < groups[g].second; ++i) {
+            if (!content::readable(files[i].path)) {
+                files[i].path.clear();
+                continue;
+            }
+            std::size_t v{0};
+            while (v < variants.size()) {
+                std::error_code ec;
+                if (content::same_contents(files[variants[v].first].path, files[i].path, ec)) {
+                    break;
+                }
+                if (!ec) {
+                    ++v;
+                }
+                else if (!content::readable(files[variants[v].first].path)) {
+                    replace(v, i);  // and compare with the new first file of variant v
+                }
+                else {
+                    files[i].path.clear();
+                    break;
+                }
+            }
+            if (files[i].path.empty()) {
+                continue;
+            }
+            if (v == variants.size()) {
+                variants.push_back(Variant{i, next_id++});
+            }
+            files[i].variant = variants[v].id;
+        }
+    });
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [](File const& f) { return f.path.empty(); }),
+                files.end());
+    keep_groups(files);
+}
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog << " [--threads <n>] [--min-size <bytes>] [--summary] <path>\n";
+}
+
+int main(int argc, char* argv[])
+{
+    WalkOptions opts;
+    std::uint64_t min_size{1};
+    bool summary{false};
+    char const* root_arg{nullptr};
+    for (int i{1}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (std::strcmp(argv[i], "--min-size") == 0 && i + 1 < argc) {
+            min_size = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (std::strcmp(argv[i], "--summary") == 0) {
+            summary = true;
+        }
+        else if (argv[i][0] == '-' || root_arg) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        else {
+            root_arg = argv[i];
+        }
+    }
+    if (!root_arg) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    fs::path root{root_arg};
+    if (!is_directory(root)) {
+        std::cerr << '"' << root.string() << "\" is not a directory\n";
+        return EXIT_FAILURE;
+    }
+
+    // symlinks aren't followed, they don't take up the space of their target
+    opts.fields = scan::field::size | scan::field::dev | scan::field::ino;
+    per_thread<std::vector<File>> found{opts.threads + 1};
+    auto const errors = parallel_walk(root, opts, [&](fs::path const& dir, scan::Entry const& e) {
+        if (e.type == fs::file_type::regular && e.size >= min_size) {
+            found.local().push_back(File{(dir / e.name).string(), e.size, e.dev, e.ino});
+        }
+    });
+    std::vector<File> files;
+    found.for_each([&](std::vector<File>& v) {
+        std::move(v.begin(), v.end(), std::back_inserter(files));
+        v = {};
+    });
+    auto const scanned = files.size();
+
+    // one file per inode - further hard links don't take up space
+    std::sort(files.begin(), files.end(), [](File const& a, File const& b) {
+        return std::tie(a.dev, a.ino, a.path) < std::tie(b.dev, b.ino, b.path);
+    });
+    files.erase(std::unique(files.begin(), files.end(),
+                            [](File const& a, File const& b) {
+                                return a.dev == b.dev && a.ino == b.ino;
+                            }),
+                files.end());
+
+    keep_groups(files);     // by size - all hashes are still 0
+    auto const by_size = files.size();
+    constexpr std::uint64_t prefix{64 * 1024};
+    hash_all(files, prefix, opts.threads);
+    keep_groups(files);
+    auto const by_prefix = files.size();
+    std::vector<File> small;
+    std::vector<File> large;
+    for (auto& f : files) {
+        (f.size > prefix ? large : small).push_back(std::move(f));
+    }
+    hash_all(large, UINT64_MAX, opts.threads);
+    keep_groups(large);
+    files = std::move(small);
+    std::move(large.begin(), large.end(), std::back_inserter(files));
+    keep_groups(files);
+    auto const by_hash = files.size();
+    confirm_groups(files, opts.threads);    // largest files first
+
+    std::uint64_t groups{0};
+    std::uint64_t reclaimable{0};
+    for (auto first = files.begin(); first != files.end();) {
+        auto const last = std::find_if(first, files.end(), [&](File const& f) {
+            return f.size != first->size || f.hash != first->hash || f.variant != first->variant;
+        });
+        auto const copies = static_cast<std::uint64_t>(last - first - 1);
+        ++groups;
+        reclaimable += copies * first->size;
+        if (!summary) {
+            std::cout << last - first << " files of " << first->size << " bytes:\n";
+            for (auto pos = first; pos != last; ++pos) {
+                std::cout << "  " << pos->path << '\n';
+            }
+        }
+        first = last;
+    }
+    std::cout << scanned << " files, " << by_size << " candidates by size, " << by_prefix
+              << " by the first " << prefix / 1024 << " KiB, " << by_hash
+              << " by the hash of all of it, " << files.size() << " compared equal\n"
+              << groups << " groups of duplicates, " << reclaimable << " bytes reclaimable\n";
+    if (errors != 0) {
+        std::cerr << errors << " directories could not be read\n";
+    }
+}
@@ -0,0 +1,425 @@
+#if !defined(DIR_WATCH_H_)
+#define DIR_WATCH_H_
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <profiler.hpp>
+#include "parallel_walk.hpp"
+
+/**
+ * A live disk-usage counter for a directory tree.
+ *
+ * The tree is scanned once with parallel_walk(), and every directory gets an inotify watch. From
+ * then on the totals are kept up to date from the change events, instead of scanning again:
+ * - a file created, deleted, moved, written or truncated in a directory marks the directory dirty,
+ *   and each dirty directory is read again (its files only) once per batch of events,
+ * - a subdirectory created or moved into the tree is scanned and watched - in the calling thread,
+ *   as it's mostly a new, empty one: workers are only started for a scan of the whole tree,
+ * - a subdirectory deleted or moved out of the tree is dropped with its subtree, and a rename within
+ *   the tree only relinks it (the MOVED_FROM and MOVED_TO events share a cookie).
+ * Each change is propagated up to the root, so the totals of the tree are available in O(1).
+ *
+ * The state per directory is fixed - its name, parent and subdirectories, the totals of its own
+ * files and of its subtree - no matter how many files it holds. The price is that a change of one
+ * file reads its whole directory again, since the old size of the file isn't known.
+ *
+ * If the kernel's event queue overflows, the whole tree is scanned again. The number of watches
+ * is limited by /proc/sys/fs/inotify/max_user_watches - directories which can't be watched are
+ * counted as errors, and their subtree isn't tracked.
+ */
+
+namespace fs = std::filesystem;
+
+class DirWatcher
+{
+public:
+    // Scans and watches `root`. Throws fs::filesystem_error if `root` can't be watched.
+    explicit DirWatcher(fs::path root, WalkOptions opts = {})
+        : fd_{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}, root_{std::move(root)}, opts_{opts}
+    {
+        if (fd_ < 0) {
+            throw fs::filesystem_error{"inotify_init1", root_,
+                                       std::error_code{errno, std::generic_category()}};
+        }
+        opts_.fields |= scan::field::size | scan::field::follow;
+        auto const ec = add_tree(root_, -1, root_.string(), opts_.threads);
+        if (root_wd_ < 0) {
+            ::close(fd_);
+            throw fs::filesystem_error{"cannot watch directory", root_, ec};
+        }
+    }
+
+    DirWatcher(DirWatcher const&) = delete;
+    DirWatcher& operator=(DirWatcher const&) = delete;
+    ~DirWatcher() { ::close(fd_); }
+
+    // Waits up to `timeout` for changes and applies all pending ones. Returns the number of
+    // events read. If the events can't be applied (or the kernel's queue overflowed), the whole
+    // tree is scanned again - only an error of that scan is thrown.
+    std::size_t poll(std::chrono::milliseconds timeout)
+    {
+        pollfd pfd{fd_, POLLIN, 0};
+        int const ready = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+        if (ready < 0 && errno != EINTR) {
+            throw fs::filesystem_error{"poll", root_,
+                                       std::error_code{errno, std::generic_category()}};
+        }
+        if (ready <= 0) {
+            return 0;
+        }
+
+        ProfileZone zone{"apply events"};
+        Batch batch;
+        std::size_t count{0};
+        bool rebuild{false};
+        try {
+            alignas(inotify_event) char buffer[64 * 1024];
+            // a bounded number of reads, so that a busy tree can't keep us here forever
+            for (int reads{0}; reads < 16; ++reads) {
+                auto const n = ::read(fd_, buffer, sizeof(buffer));
+                if (n <= 0) {
+                    break;  // EAGAIN - all events read
+                }
+                for (char const* p = buffer; p < buffer + n;) {
+                    auto const& event = *reinterpret_cast<inotify_event const*>(p);
+                    p += sizeof(inotify_event) + event.len;
+                    ++count;
+                    apply(event, batch);
+                }
+            }
+            rebuild = batch.overflow;
+            if (!rebuild) {
+                // the other end of these moves is outside the tree
+                for (auto const& [cookie, wd] : batch.moved) {
+                    if (dirs_.count(wd)) {
+                        remove_tree(wd);
+                    }
+                }
+                for (int const wd : batch.dirty) {
+                    if (dirs_.count(wd)) {
+                        rescan_own(wd);
+                    }
+                }
+            }
+        }
+        catch (std::exception const&) {
+            // e.g. out of memory while adding a subtree - which may be half linked, start over
+            ++errors_;
+            rebuild = true;
+        }
+        if (rebuild) {
+            reset();
+            add_tree(root_, -1, root_.string(), opts_.threads);
+        }
+        return count;
+    }
+
+    // Totals of the whole tree. Can be called from any thread; files and bytes are each
+    // up to date, but not necessarily updated together.
+    DirTotals total() const noexcept
+    {
+        return DirTotals{files_.load(std::memory_order_relaxed),
+                         bytes_.load(std::memory_order_relaxed)};
+    }
+
+    // Number of watched directories.
+    std::size_t directories() const noexcept { return dirs_.size(); }
+
+    // Number of directories which couldn't be read or watched.
+    std::uintmax_t errors() const noexcept { return errors_; }
+
+private:
+    static constexpr std::uint32_t watch_mask{IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                                              | IN_CLOSE_WRITE | IN_MODIFY | IN_ONLYDIR
+                                              | IN_DONT_FOLLOW | IN_EXCL_UNLINK};
+
+    struct Dir {
+        int parent{-1};         // watch descriptor of the parent, -1 for the root
+        std::string name{};     // relative to the parent, the full path for the root
+        DirTotals own{};
+        DirTotals total{};
+        std::vector<int> children{};
+    };
+
+    // state of one poll()
+    struct Batch {
+        std::unordered_set<int> dirty{};
+        std::unordered_map<std::uint32_t, int> moved{};    // cookie -> directory moved away
+        bool overflow{false};
+    };
+
+    void apply(inotify_event const& event, Batch& batch)
+    {
+        if (event.mask & IN_Q_OVERFLOW) {
+            batch.overflow = true;
+            return;
+        }
+        if (batch.overflow || !dirs_.count(event.wd)) {
+            return;     // already dropped
+        }
+        if (event.mask & IN_IGNORED) {
+            remove_tree(event.wd);  // the directory itself is gone, or was unmounted
+            return;
+        }
+        if (!(event.mask & IN_ISDIR)) {
+            batch.dirty.insert(event.wd);
+            return;
+        }
+        std::string_view const name{event.name};
+        if (event.mask & IN_MOVED_FROM) {
+            int const child = find_child(event.wd, name);
+            if (child >= 0) {
+                batch.moved[event.cookie] = child;
+            }
+        }
+        else if (event.mask & IN_MOVED_TO) {
+            auto const pos = batch.moved.find(event.cookie);
+            if (pos != batch.moved.end() && dirs_.count(pos->second)) {
+                relink(pos->second, event.wd, std::string{name});
+                batch.moved.erase(pos);
+            }
+            else {
+                add_tree(path_of(event.wd) / name, event.wd, std::string{name}, 1);
+            }
+        }
+        else if (event.mask & IN_CREATE) {
+            add_tree(path_of(event.wd) / name, event.wd, std::string{name}, 1);
+        }
+        else if (event.mask & IN_DELETE) {
+            int const child = find_child(event.wd, name);
+            if (child >= 0) {
+                remove_tree(child);
+            }
+        }
+    }
+
+    // Scans and watches the tree below `top` with `threads` workers (1: no new threads), and
+    // links it into `parent`.
+    std::error_code add_tree(fs::path const& top, int parent, std::string name,
+                             std::size_t threads)
+    {
+        int const top_wd = ::inotify_add_watch(fd_, top.c_str(), watch_mask);
+        if (top_wd < 0) {
+            ++errors_;
+            return {errno, std::generic_category()};
+        }
+        if (!dirs_.emplace(top_wd, Dir{parent, std::move(name)}).second) {
+            return {};  // already watched - reached twice in one batch
+        }
+
+        // the walker reports directories by path - map them to their watches during the scan
+        std::mutex mutex;
+        std::unordered_map<std::string, int> wd_of{{top.native(), top_wd}};
+        std::vector<std::pair<int, std::string>> links;     // watch, path of the parent
+        std::uintmax_t errors{0};
+        auto opts = opts_;
+        opts.threads = threads;
+        errors += parallel_walk(top, opts,
+            [&](fs::path const& dir, scan::Entry const& entry) {
+                if (entry.type != fs::file_type::directory || entry.symlink) {
+                    return;
+                }
+                auto const path = dir / entry.name;
+                int const wd = ::inotify_add_watch(fd_, path.c_str(), watch_mask);
+                std::lock_guard<std::mutex> lock{mutex};
+                if (wd < 0) {
+                    ++errors;
+                }
+                else if (dirs_.emplace(wd, Dir{-1, std::string{entry.name}}).second) {
+                    wd_of.emplace(path.native(), wd);
+                    links.emplace_back(wd, dir.native());
+                }
+            },
+            [&](fs::path const& dir, DirTotals const& own) {
+                std::lock_guard<std::mutex> lock{mutex};
+                auto const pos = wd_of.find(dir.native());
+                if (pos != wd_of.end()) {
+                    dirs_.at(pos->second).own = own;
+                }
+            });
+        errors_ += errors;
+
+        std::vector<int> orphans;   // below a directory which couldn't be watched
+        for (auto const& [wd, parent_path] : links) {
+            auto const pos = wd_of.find(parent_path);
+            if (pos == wd_of.end()) {
+                orphans.push_back(wd);
+                continue;
+            }
+            dirs_.at(wd).parent = pos->second;
+            dirs_.at(pos->second).children.push_back(wd);
+        }
+        for (int const wd : orphans) {
+            remove_tree(wd);
+        }
+
+        // sum up the subtree totals, children before their parents
+        std::vector<int> order{top_wd};
+        for (std::size_t i{0}; i < order.size(); ++i) {
+            auto const& children = dirs_.at(order[i]).children;
+            order.insert(order.end(), children.begin(), children.end());
+        }
+        for (auto pos = order.rbegin(); pos != order.rend(); ++pos) {
+            auto& dir = dirs_.at(*pos);
+            dir.total = dir.own;
+            for (int const child : dir.children) {
+                dir.total.files += dirs_.at(child).total.files;
+                dir.total.bytes += dirs_.at(child).total.bytes;
+            }
+        }
+
+        if (parent < 0) {
+            root_wd_ = top_wd;
+        }
+        else {
+            dirs_.at(parent).children.push_back(top_wd);
+        }
+        propagate(parent, dirs_.at(top_wd).total);
+        return {};
+    }
+
+    // Drops all watches and totals, before the whole tree is scanned again.
+    void reset() noexcept
+    {
+        for (auto const& entry : dirs_) {
+            ::inotify_rm_watch(fd_, entry.first);
+        }
+        dirs_.clear();
+        root_wd_ = -1;
+        files_.store(0, std::memory_order_relaxed);
+        bytes_.store(0, std::memory_order_relaxed);
+    }
+
+    // Unlinks the subtree of `wd` from its parent, and drops it with all its watches.
+    void remove_tree(int wd)
+    {
+        auto const& dir = dirs_.at(wd);
+        propagate(dir.parent, negate(dir.total));
+        unlink(wd);
+        std::vector<int> stack{wd};
+        while (!stack.empty()) {
+            auto const pos = dirs_.find(stack.back());
+            stack.pop_back();
+            stack.insert(stack.end(), pos->second.children.begin(), pos->second.children.end());
+            ::inotify_rm_watch(fd_, pos->first);    // fails harmlessly if the directory is gone
+            dirs_.erase(pos);
+        }
+    }
+
+    // A directory was renamed within the tree - only its position changes.
+    void relink(int wd, int parent, std::string name)
+    {
+        auto& dir = dirs_.at(wd);
+        propagate(dir.parent, negate(dir.total));
+        unlink(wd);
+        dir.parent = parent;
+        dir.name = std::move(name);
+        dirs_.at(parent).children.push_back(wd);
+        propagate(parent, dir.total);
+    }
+
+    void unlink(int wd)
+    {
+        int const parent = dirs_.at(wd).parent;
+        if (parent < 0) {
+            root_wd_ = -1;
+            return;
+        }
+        auto& siblings = dirs_.at(parent).children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), wd));
+    }
+
+    // Reads the files of a directory again.
+    void rescan_own(int wd)
+    {
+        std::error_code ec;
+        auto const d = scan::Directory::open(path_of(wd), ec);
+        if (!d) {
+            return;     // gone - reported by an event of its parent
+        }
+        DirTotals own;
+        ec = d.for_each(opts_.fields, [&](scan::Entry const& entry) {
+            if (entry.type == fs::file_type::regular) {
+                ++own.files;
+                own.bytes += entry.size;
+            }
+        });
+        auto& dir = dirs_.at(wd);
+        propagate(wd, DirTotals{own.files - dir.own.files, own.bytes - dir.own.bytes});
+        dir.own = own;
+    }
+
+    // Adds `delta` to the totals of `wd` and all its ancestors. Unsigned arithmetic wraps
+    // around, so a negated delta subtracts.
+    void propagate(int wd, DirTotals const& delta) noexcept
+    {
+        for (; wd >= 0; wd = dirs_.at(wd).parent) {
+            auto& total = dirs_.at(wd).total;
+            total.files += delta.files;
+            total.bytes += delta.bytes;
+        }
+        files_.fetch_add(delta.files, std::memory_order_relaxed);
+        bytes_.fetch_add(delta.bytes, std::memory_order_relaxed);
+    }
+
+    static DirTotals negate(DirTotals const& t) noexcept
+    {
+        return DirTotals{0 - t.files, 0 - t.bytes};
+    }
+
+    int find_child(int wd, std::string_view name) const
+    {
+        for (int const child : dirs_.at(wd).children) {
+            if (dirs_.at(child).name == name) {
+                return child;
+            }
+        }
+        return -1;
+    }
+
+    fs::path path_of(int wd) const
+    {
+        std::vector<std::string const*> names;
+        for (; wd >= 0; wd = dirs_.at(wd).parent) {
+            names.push_back(&dirs_.at(wd).name);
+        }
+        fs::path path;
+        for (auto pos = names.rbegin(); pos != names.rend(); ++pos) {
+            path /= **pos;
+        }
+        return path;
+    }
+
+    int fd_;
+    fs::path const root_;
+    WalkOptions opts_;
+    int root_wd_{-1};
+    std::unordered_map<int, Dir> dirs_{};   // by watch descriptor
+    std::uintmax_t errors_{0};
+    std::atomic<std::uintmax_t> files_{0};
+    std::atomic<std::uintmax_t> bytes_{0};
+};
+
+#endif // __linux__
+
+#endif // DIR_WATCH_H_
@@ -1,39 +1,141 @@
-#include <execution>  // for the execution policy
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
-#include <numeric>  // for transform_reduce()
-#include <vector>
+
+#include <profiler.hpp>
+#include "du_index.hpp"
+#include "parallel_walk.hpp"
+
+/**
+ * The straightforward C++17 way to sum up the size of a tree is to copy all the paths out of a
+ * recursive_directory_iterator into a std::vector<fs::path>, and then
+ *     std::transform_reduce(std::execution::par, paths..., [](const fs::path& p) {
+ *         if (is_regular_file(p)) { return file_size(p); }
+ *         return std::uintmax_t{0};
+ *     });
+ * This materializes every path of the tree, iterates over the tree serially, and calls stat()
+ * twice more per entry, although the iterator already knew the type of each entry.
+ *
+ * parallel_dirsize() streams over the tree with a pool of workers instead (see parallel_walk.hpp).
+ *
+ * With --backend uring the metadata calls of each worker are batched and submitted to io_uring,
+ * keeping many of them in flight (see metadata.hpp).
+ *
+ * With --unique every file is counted once, however many hard links or symlinks lead to it, and
+ * --follow descends into directory symlinks as well - each directory is read once, so symlinks
+ * pointing back up the tree don't loop (see visited_set.hpp).
+ *
+ * With --index <file> the per-directory sizes are kept in a persistent index, and a rerun only
+ * reads the directories which changed since the index was written (see du_index.hpp).
+ */
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog
+              << " [--threads <n>] [--backend sync|uring] [--unique] [--follow] [--trace <file>]"
+                 " <path>\n"
+              << "       " << prog << " --index <file> <path>\n"
+              << "  --index: a single-threaded, incremental scan - no other options\n";
+}
 
 int main(int argc, char* argv[])
 {
     namespace fs = std::filesystem;
+    WalkOptions opts;
+    char const* trace_file{nullptr};
+    char const* index_file{nullptr};
+    char const* root_arg{nullptr};
+    bool walk_options{false};   // not supported by the index, see du::Updater
+    for (int i{1}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--index") != 0 && std::strncmp(argv[i], "--", 2) == 0) {
+            walk_options = true;
+        }
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            ++i;
+            if (std::strcmp(argv[i], "uring") == 0) {
+                opts.backend = scan::Backend::uring;
+            }
+            else if (std::strcmp(argv[i], "sync") != 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[i], "--unique") == 0) {
+            opts.unique = true;
+        }
+        else if (std::strcmp(argv[i], "--follow") == 0) {
+            opts.follow_symlinks = true;
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            index_file = argv[++i];
+        }
+        else if (argv[i][0] == '-' || root_arg) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        else {
+            root_arg = argv[i];
+        }
+    }
     // root directory is passed as command line argument:
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path> \n";
+    if (!root_arg || (index_file && walk_options)) {
+        usage(argv[0]);
         return EXIT_FAILURE;
     }
-    fs::path root{argv[1]};
-
-    // init list of all file paths in passed file tree:
-    std::vector<fs::path> paths;
-    try {
-        fs::recursive_directory_iterator dirpos{root};
-        std::copy(begin(dirpos), end(dirpos), std::back_inserter(paths));
-    }
-    catch (const std::exception& e) {
-        std::cerr << "EXCEPTION: " << e.what() << std::endl;
+    fs::path root{root_arg};
+    if (!is_directory(root)) {
+        std::cerr << '"' << root.string() << "\" is not a directory\n";
         return EXIT_FAILURE;
     }
+    Profiler::instance().enable(trace_file != nullptr);
+    if (opts.backend == scan::Backend::uring && !scan::Metadata{opts.backend, 1}.async()) {
+        std::cerr << "io_uring is not available, using synchronous calls\n";
+    }
+
+    if (index_file) {
+        du::Index old;
+        old.open(index_file);   // a missing or invalid index just means a full scan
+        du::Updater updater{old};
+        if (!updater.update(root)) {
+            std::cerr << "cannot scan \"" << root.string() << "\"\n";
+            return EXIT_FAILURE;
+        }
+        try {
+            updater.write(index_file);
+        }
+        catch (fs::filesystem_error const& e) {
+            std::cerr << "EXCEPTION: " << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        auto const totals = updater.totals();
+        auto const& stats = updater.stats();
+        std::cout << "size of all " << totals.total_files << " regular files: "
+                  << totals.total_bytes << '\n'
+                  << stats.reused << " directories unchanged, " << stats.scanned << " rescanned\n";
+        if (stats.errors != 0) {
+            std::cerr << stats.errors << " directories could not be read\n";
+        }
+        return EXIT_SUCCESS;
+    }
 
     // accumulate size of all regular files:
-    auto const sz =
-        std::transform_reduce(std::execution::par,         // parallel execution
-                              cbegin(paths), cend(paths),  // range
-                              std::uintmax_t{0},           // initial value
-                              std::plus<>(),               // accumulate ...
-                              [](const fs::path& p) {      //  file size if regular file
-                                  if (is_regular_file(p)) { return file_size(p); }
-                                  return std::uintmax_t{0};
-                              });
-    std::cout << "size of all " << paths.size() << " regular files: " << sz << '\n';
+    auto const sz = parallel_dirsize(root, opts);
+    std::cout << "size of all " << sz.files << " regular files: " << sz.bytes << '\n';
+    if (sz.errors != 0) {
+        std::cerr << sz.errors << " directories could not be read\n";
+    }
+
+    if (trace_file) {
+        std::ofstream trace{trace_file};
+        Profiler::instance().write_chrome_trace(trace);
+    }
 }
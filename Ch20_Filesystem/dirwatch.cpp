@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+
+#if defined(__linux__)
+#include "dir_watch.hpp"
+#endif
+
+/**
+ * Keeps the size of a directory tree up to date, e.g. of a spool directory, without rescanning
+ * it: after one parallel scan, the totals are maintained from inotify events (see dir_watch.hpp)
+ * and printed whenever they change.
+ */
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog << " [--threads <n>] [--seconds <n>] <path>\n"
+              << "  --seconds: stop after n seconds (default: run until interrupted)\n";
+}
+
+int main(int argc, char* argv[])
+{
+#if defined(__linux__)
+    namespace fs = std::filesystem;
+    using namespace std::chrono;
+    WalkOptions opts;
+    long long seconds{0};
+    char const* root_arg{nullptr};
+    for (int i{1}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::strtoll(argv[++i], nullptr, 10);
+        }
+        else {
+            root_arg = argv[i];
+        }
+    }
+    if (!root_arg) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // a long-running process - no profiling, the events would only pile up
+    Profiler::instance().enable(false);
+    try {
+        auto const start = steady_clock::now();
+        DirWatcher watcher{root_arg, opts};
+        auto const print = [&](char const* what) {
+            auto const total = watcher.total();
+            std::cout << what << ": " << total.files << " regular files, " << total.bytes
+                      << " bytes in " << watcher.directories() << " directories" << std::endl;
+        };
+        std::cout << "scanned in "
+                  << duration<double, std::milli>{steady_clock::now() - start}.count() << "ms\n";
+        print("initial");
+        if (watcher.errors() != 0) {
+            std::cerr << watcher.errors() << " directories could not be read or watched\n";
+        }
+
+        auto const stop = start + std::chrono::seconds{seconds};
+        auto last = watcher.total();
+        while (seconds <= 0 || steady_clock::now() < stop) {
+            watcher.poll(milliseconds{500});
+            auto const total = watcher.total();
+            if (total.files != last.files || total.bytes != last.bytes) {
+                print("changed");
+                last = total;
+            }
+        }
+    }
+    catch (fs::filesystem_error const& e) {
+        std::cerr << "EXCEPTION: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    catch (std::exception const& e) {
+        std::cerr << "EXCEPTION: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+#else
+    (void)argc;
+    std::cerr << argv[0] << ": inotify is only available on Linux\n";
+    return EXIT_FAILURE;
+#endif
+}
@@ -0,0 +1,393 @@
+#if !defined(DU_INDEX_H_)
+#define DU_INDEX_H_
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "scan.hpp"
+
+#if defined(SCAN_POSIX)
+#include <sys/mman.h>
+#endif
+
+/**
+ * A persistent, incremental disk-usage index.
+ *
+ * The index file stores one fixed-size `DirRecord` per directory of the tree - its device, inode
+ * and mtime, the size and number of the regular files directly in it, the totals of its subtree,
+ * and the range of its subdirectory records. It's memory-mapped for reading, so loading the index
+ * costs no parsing.
+ *
+ * A directory's mtime changes whenever an entry is added, removed or renamed in it. A rescan
+ * therefore reuses the record of every directory whose (dev, inode, mtime) is unchanged, and only
+ * stat()s its subdirectories (by name, from the index) to check them in turn. Only directories
+ * whose mtime changed are read again and their files stat()ed.
+ *
+ * Caveat: writing to an existing file doesn't change the mtime of its directory. Files which grew
+ * or shrank in place are only picked up once their directory changes (or with a full rescan).
+ *
+ * File layout (native endianness, all offsets 8-byte aligned):
+ *   IndexHeader | DirRecord[num_dirs] (root first, children contiguous) | names[names_size]
+ */
+
+namespace du {
+
+namespace fs = std::filesystem;
+
+struct IndexHeader {
+    char magic[4]{'D', 'U', 'I', 'X'};
+    std::uint32_t version{1};
+    std::uint64_t num_dirs{0};
+    std::uint64_t names_size{0};
+    std::uint64_t reserved{0};
+};
+
+struct DirRecord {
+    std::uint64_t dev{0};
+    std::uint64_t ino{0};
+    std::int64_t mtime_ns{0};
+    std::uint64_t own_bytes{0};
+    std::uint64_t own_files{0};
+    std::uint64_t total_bytes{0};
+    std::uint64_t total_files{0};
+    std::uint32_t first_child{0};
+    std::uint32_t num_children{0};
+    std::uint32_t name_offset{0};   // name relative to the parent, the full path for the root
+    std::uint32_t name_size{0};
+};
+
+static_assert(std::is_trivially_copyable_v<IndexHeader> && sizeof(IndexHeader) == 32);
+static_assert(std::is_trivially_copyable_v<DirRecord> && sizeof(DirRecord) == 72);
+
+// Read-only view of an index file.
+class Index
+{
+public:
+    Index() = default;
+    Index(Index const&) = delete;
+    Index& operator=(Index const&) = delete;
+    ~Index() { unmap(); }
+
+    // Returns false if the file doesn't exist or isn't a valid index.
+    bool open(fs::path const& file)
+    {
+        unmap();
+        if (!map(file)) {
+            return false;
+        }
+        IndexHeader header;
+        if (size_ < sizeof(header)) {
+            unmap();
+            return false;
+        }
+        std::memcpy(&header, data_, sizeof(header));
+        // sizes from the file are compared by division, so they can't overflow
+        auto const space = size_ - sizeof(header);
+        if (std::memcmp(header.magic, IndexHeader{}.magic, 4) != 0
+            || header.version != IndexHeader{}.version
+            || header.num_dirs > space / sizeof(DirRecord)
+            || header.names_size != space - header.num_dirs * sizeof(DirRecord)) {
+            unmap();
+            return false;
+        }
+        records_ = reinterpret_cast<DirRecord const*>(data_ + sizeof(header));
+        num_records_ = header.num_dirs;
+        names_ = reinterpret_cast<char const*>(records_ + num_records_);
+        // every child range and name within the file - all of it is read without further checks
+        for (std::size_t i{0}; i < num_records_; ++i) {
+            auto const& r = records_[i];
+            if (std::uint64_t{r.first_child} + r.num_children > num_records_
+                || std::uint64_t{r.name_offset} + r.name_size > header.names_size) {
+                unmap();
+                return false;
+            }
+        }
+        by_inode_.clear();
+        by_inode_.reserve(num_records_);
+        for (std::size_t i{0}; i < num_records_; ++i) {
+            by_inode_.emplace(Key{records_[i].dev, records_[i].ino}, i);
+        }
+        return true;
+    }
+
+    std::size_t size() const noexcept { return num_records_; }
+    DirRecord const* root() const noexcept { return num_records_ ? records_ : nullptr; }
+    DirRecord const& operator[](std::size_t i) const noexcept { return records_[i]; }
+
+    std::string_view name(DirRecord const& r) const noexcept
+    {
+        return {names_ + r.name_offset, r.name_size};
+    }
+
+    DirRecord const* find(std::uint64_t dev, std::uint64_t ino) const
+    {
+        auto const pos = by_inode_.find(Key{dev, ino});
+        return pos == by_inode_.end() ? nullptr : records_ + pos->second;
+    }
+
+private:
+    struct Key {
+        std::uint64_t dev;
+        std::uint64_t ino;
+        bool operator==(Key const& o) const noexcept { return dev == o.dev && ino == o.ino; }
+    };
+    struct KeyHash {
+        std::size_t operator()(Key const& k) const noexcept
+        {
+            return std::hash<std::uint64_t>{}(k.ino * 0x9E3779B97F4A7C15ull ^ k.dev);
+        }
+    };
+
+#if defined(SCAN_POSIX)
+    bool map(fs::path const& file)
+    {
+        int const fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        void* const p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);    // the mapping keeps the file open
+        if (p == MAP_FAILED) {
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<char const*>(p);
+        return true;
+    }
+
+    void unmap() noexcept
+    {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        num_records_ = 0;
+    }
+#else
+    // no mmap() - read the file into memory
+    bool map(fs::path const& file)
+    {
+        std::ifstream in{file, std::ios::binary};
+        if (!in) {
+            return false;
+        }
+        buffer_.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+
+    void unmap() noexcept
+    {
+        buffer_.clear();
+        data_ = nullptr;
+        size_ = 0;
+        num_records_ = 0;
+    }
+
+    std::vector<char> buffer_{};
+#endif
+
+    char const* data_{nullptr};
+    std::size_t size_{0};
+    DirRecord const* records_{nullptr};
+    std::size_t num_records_{0};
+    char const* names_{nullptr};
+    std::unordered_map<Key, std::size_t, KeyHash> by_inode_{};
+};
+
+struct ScanStats {
+    std::uint64_t reused{0};    // directories taken over from the old index
+    std::uint64_t scanned{0};   // directories read again
+    std::uint64_t errors{0};
+};
+
+// Scans a tree, reusing an old index where possible, and writes the new index.
+class Updater
+{
+public:
+    explicit Updater(Index const& old) noexcept : old_{old} { }
+
+    // Returns false if `root` can't be stat()ed.
+    bool update(fs::path const& root)
+    {
+        std::error_code ec;
+        auto const st = scan::stat(root, dir_fields | scan::field::follow, ec);
+        if (ec || st.type != fs::file_type::directory) {
+            return false;
+        }
+        root_ = Node{};
+        root_.name = root.string();
+        fill(root_, root, st);
+        return true;
+    }
+
+    DirRecord totals() const noexcept { return root_.rec; }
+    ScanStats const& stats() const noexcept { return stats_; }
+
+    // Writes to a temporary file first, which then replaces `file` - readers of the old index
+    // keep a consistent mapping.
+    void write(fs::path const& file) const
+    {
+        // breadth first, so that the children of each directory are stored contiguously
+        std::vector<DirRecord> records;
+        std::string names;
+        std::deque<std::pair<Node const*, std::size_t>> queue;
+        records.push_back(root_.rec);
+        queue.emplace_back(&root_, 0);
+        while (!queue.empty()) {
+            auto const [node, index] = queue.front();
+            queue.pop_front();
+            auto& rec = records[index];
+            rec.name_offset = static_cast<std::uint32_t>(names.size());
+            rec.name_size = static_cast<std::uint32_t>(node->name.size());
+            names += node->name;
+            rec.first_child = static_cast<std::uint32_t>(records.size());
+            rec.num_children = static_cast<std::uint32_t>(node->children.size());
+            for (auto const& child : node->children) {
+                queue.emplace_back(&child, records.size());
+                records.push_back(child.rec);
+            }
+        }
+        names.resize((names.size() + 7) / 8 * 8, '\0');
+
+        IndexHeader header;
+        header.num_dirs = records.size();
+        header.names_size = names.size();
+        auto tmp{file};
+        tmp += ".tmp";
+        {
+            std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+            out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+            out.write(reinterpret_cast<char const*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(DirRecord)));
+            out.write(names.data(), static_cast<std::streamsize>(names.size()));
+            if (!out.flush()) {
+                throw fs::filesystem_error{"cannot write index", tmp,
+                                           std::make_error_code(std::errc::io_error)};
+            }
+        }
+        fs::rename(tmp, file);
+    }
+
+private:
+    static constexpr unsigned dir_fields{scan::field::type | scan::field::mtime | scan::field::dev
+                                         | scan::field::ino};
+
+    struct Node {
+        DirRecord rec{};
+        std::string name{};
+        std::vector<Node> children{};
+    };
+
+    void fill(Node& node, fs::path const& path, scan::Entry const& st)
+    {
+        node.rec.dev = st.dev;
+        node.rec.ino = st.ino;
+        node.rec.mtime_ns = st.mtime_ns;
+        std::error_code ec;
+        auto const dir = scan::Directory::open(path, ec);
+        if (!dir) {
+            ++stats_.errors;
+            return;
+        }
+        auto const* const old = old_.find(st.dev, st.ino);
+        if (old && old->mtime_ns == st.mtime_ns) {
+            reuse(node, path, dir, *old);
+        }
+        else {
+            rescan(node, path, dir);
+        }
+        node.rec.total_bytes += node.rec.own_bytes;
+        node.rec.total_files += node.rec.own_files;
+    }
+
+    // The entries of the directory are unchanged: take over its own files, and check each of its
+    // subdirectories with a single stat.
+    void reuse(Node& node, fs::path const& path, scan::Directory const& dir, DirRecord const& old)
+    {
+        auto const before = stats_;
+        ++stats_.reused;
+        node.rec.own_bytes = old.own_bytes;
+        node.rec.own_files = old.own_files;
+        for (std::uint32_t i{0}; i < old.num_children; ++i) {
+            auto const& old_child = old_[old.first_child + i];
+            std::string name{old_.name(old_child)};
+            scan::Entry st;
+            auto const ec = scan::detail::stat_at(dir.fd(), name.c_str(), dir_fields, st);
+            if (ec || st.type != fs::file_type::directory) {
+                // the mtime of the parent is unchanged, but the subdirectory is gone (or was
+                // replaced within the mtime granularity) - rescan the parent instead, without
+                // the counts of the subdirectories already taken over
+                node.children.clear();
+                node.rec = DirRecord{node.rec.dev, node.rec.ino, node.rec.mtime_ns};
+                stats_ = before;
+                rescan(node, path, dir);
+                return;
+            }
+            add_child(node, path, std::move(name), st);
+        }
+    }
+
+    void rescan(Node& node, fs::path const& path, scan::Directory const& dir)
+    {
+        ++stats_.scanned;
+        std::vector<std::string> subdirs;
+        auto const ec = dir.for_each(scan::field::size | scan::field::follow,
+                                     [&](scan::Entry const& e) {
+            if (e.type == fs::file_type::regular) {
+                node.rec.own_bytes += e.size;
+                ++node.rec.own_files;
+            }
+            else if (e.type == fs::file_type::directory && !e.symlink) {
+                subdirs.emplace_back(e.name);
+            }
+        });
+        if (ec) {
+            ++stats_.errors;
+        }
+        for (auto& name : subdirs) {
+            scan::Entry st;
+            if (scan::detail::stat_at(dir.fd(), name.c_str(), dir_fields, st)) {
+                ++stats_.errors;
+                continue;
+            }
+            add_child(node, path, std::move(name), st);
+        }
+    }
+
+    void add_child(Node& node, fs::path const& path, std::string name, scan::Entry const& st)
+    {
+        auto& child = node.children.emplace_back();
+        child.name = std::move(name);
+        fill(child, path / child.name, st);
+        node.rec.total_bytes += child.rec.total_bytes;
+        node.rec.total_files += child.rec.total_files;
+    }
+
+    Index const& old_;
+    Node root_{};
+    ScanStats stats_{};
+};
+
+} // namespace du
+
+#endif // DU_INDEX_H_
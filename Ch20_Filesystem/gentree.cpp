@@ -0,0 +1,348 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <per_thread.hpp>
+#include "parallel_for.hpp"
+#include "scan.hpp"
+
+/**
+ * Generates a synthetic directory tree for file system benchmarks - like create_files.cpp, which
+ * creates one directory, one file and one symlink, but parameterised and at scale:
+ * - `depth` levels of directories below the root, each with `fanout` subdirectories,
+ * - `files` entries per directory, each a symlink with probability `symlink ratio` (half of them
+ *   to a sibling, half to an ancestor directory - a cycle for walkers following symlinks),
+ *   otherwise a regular file with a size from the given distribution,
+ * - all of it derived from `seed`: the same parameters create the same tree, whatever the number
+ *   of threads (the random numbers of each directory only depend on the seed and its number, and
+ *   the distributions are computed here rather than with the implementation-defined ones of
+ *   <random>).
+ * The directories are created level by level, then all directories are filled in parallel. With
+ * --fallocate the file space is only allocated, not written.
+ */
+
+namespace fs = std::filesystem;
+
+// splitmix64 - a fast, well-mixing generator, also used to derive the seed of each directory
+struct SplitMix {
+    std::uint64_t state;
+
+    std::uint64_t operator()() noexcept
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double unit() noexcept { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; }
+};
+
+struct SizeDist {
+    enum class Kind { fixed, uniform, lognormal };
+    Kind kind{Kind::fixed};
+    double a{4096};     // fixed: size, uniform: min, lognormal: mean of ln(size)
+    double b{0};        // uniform: max, lognormal: standard deviation of ln(size)
+
+    std::uint64_t operator()(SplitMix& rng) const noexcept
+    {
+        constexpr double max_size{1ull << 40};
+        switch (kind) {
+        case Kind::fixed:
+            return static_cast<std::uint64_t>(a);
+        case Kind::uniform:
+            return static_cast<std::uint64_t>(a + (b - a + 1) * rng.unit());
+        case Kind::lognormal: {
+            // Box-Muller
+            constexpr double pi{3.14159265358979323846};
+            double const u1 = 1.0 - rng.unit();
+            double const u2 = rng.unit();
+            double const z = std::sqrt(-2.0 * std::log(u1)) * std::cos(2 * pi * u2);
+            return static_cast<std::uint64_t>(std::min(std::exp(a + b * z), max_size));
+        }
+        }
+        return 0;
+    }
+
+    // "fixed:<bytes>", "uniform:<min>:<max>" or "lognormal:<mu>:<sigma>"
+    static bool parse(std::string_view spec, SizeDist& dist)
+    {
+        auto const colon = spec.find(':');
+        auto const kind = spec.substr(0, colon);
+        std::string const args{colon == spec.npos ? "" : spec.substr(colon + 1)};
+        char* end{nullptr};
+        dist.a = std::strtod(args.c_str(), &end);
+        dist.b = *end == ':' ? std::strtod(end + 1, &end) : 0.0;
+        if (kind == "fixed") {
+            dist.kind = Kind::fixed;
+        }
+        else if (kind == "uniform") {
+            dist.kind = Kind::uniform;
+        }
+        else if (kind == "lognormal") {
+            dist.kind = Kind::lognormal;
+        }
+        else {
+            return false;
+        }
+        return !args.empty() && *end == '\0' && dist.a >= 0 && dist.b >= 0
+               && (dist.kind != Kind::uniform || dist.b >= dist.a);
+    }
+};
+
+struct TreeSpec {
+    unsigned depth{3};
+    unsigned fanout{8};
+    unsigned files{32};     // entries per directory
+    double symlink_ratio{0.0};
+    std::uint64_t seed{42};
+    SizeDist sizes{};
+    bool fallocate{false};
+    std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+};
+
+// Counters with a slot for each of `threads` workers, and for the main thread.
+struct TreeStats {
+    explicit TreeStats(std::size_t threads)
+        : files{threads + 1}, symlinks{threads + 1}, bytes{threads + 1}, errors{threads + 1} { }
+
+    per_thread_counter<std::uint64_t> files;
+    per_thread_counter<std::uint64_t> symlinks;
+    per_thread_counter<std::uint64_t> bytes;
+    per_thread_counter<std::uint64_t> errors;
+};
+
+// Directories are numbered breadth first: the root is 0, the children of directory i are
+// i * fanout + 1 ... i * fanout + fanout.
+class TreeGenerator
+{
+public:
+    TreeGenerator(fs::path root, TreeSpec const& spec) : root_{std::move(root)}, spec_{spec} { }
+
+    std::uint64_t directories() const noexcept
+    {
+        std::uint64_t total{0};
+        std::uint64_t level{1};
+        for (unsigned d{0}; d <= spec_.depth; ++d, level *= spec_.fanout) {
+            total += level;
+        }
+        return total;
+    }
+
+    void run(TreeStats& stats)
+    {
+        std::error_code ec;
+        fs::create_directories(root_, ec);
+        if (ec) {
+            throw fs::filesystem_error{"cannot create root", root_, ec};
+        }
+        // parents have to exist before their children
+        std::uint64_t first{1};
+        std::uint64_t level{spec_.fanout};
+        for (unsigned d{1}; d <= spec_.depth; ++d, first += level, level *= spec_.fanout) {
+            parallel_for_index(level, spec_.threads, [&](std::size_t i) {
+                std::error_code dir_ec;
+                if (!fs::create_directory(path_of(first + i), dir_ec) && dir_ec) {
+                    add(stats.errors, 1);
+                }
+            });
+        }
+        parallel_for_index(directories(), spec_.threads, [&](std::size_t i) {
+            fill(i, stats);
+        });
+    }
+
+private:
+    fs::path path_of(std::uint64_t id) const
+    {
+        std::string rel;
+        for (; id != 0; id = (id - 1) / spec_.fanout) {
+            rel.insert(0, "/d" + std::to_string((id - 1) % spec_.fanout));
+        }
+        return root_.string() + rel;
+    }
+
+    unsigned level_of(std::uint64_t id) const noexcept
+    {
+        unsigned level{0};
+        for (; id != 0; id = (id - 1) / spec_.fanout) {
+            ++level;
+        }
+        return level;
+    }
+
+    void fill(std::uint64_t id, TreeStats& stats)
+    {
+        SplitMix rng{spec_.seed ^ SplitMix{id}()};
+        auto const dir = path_of(id);
+        auto const level = level_of(id);
+        for (unsigned j{0}; j < spec_.files; ++j) {
+            if (rng.unit() < spec_.symlink_ratio) {
+                std::string target;
+                if (j > 0 && (rng() & 1)) {
+                    target = "f" + std::to_string(rng() % j);     // may itself be a symlink
+                }
+                else if (level == 0) {
+                    target = ".";
+                }
+                else {
+                    for (auto up = 1 + rng() % level; up != 0; --up) {
+                        target += up == 1 ? ".." : "../";
+                    }
+                }
+                std::error_code ec;
+                fs::create_symlink(target, dir / ("f" + std::to_string(j)), ec);
+                add(ec ? stats.errors : stats.symlinks, 1);
+                continue;
+            }
+            auto const size = spec_.sizes(rng);
+            if (write_file(dir / ("f" + std::to_string(j)), size, rng())) {
+                add(stats.files, 1);
+                add(stats.bytes, size);
+            }
+            else {
+                add(stats.errors, 1);
+            }
+        }
+    }
+
+    bool write_file(fs::path const& path, std::uint64_t size, std::uint64_t content_seed) const
+    {
+        // the content repeats after one buffer - distinct per file, cheap to produce
+        constexpr std::size_t chunk{64 * 1024};
+        thread_local std::vector<std::uint64_t> buffer(chunk / sizeof(std::uint64_t));
+        if (!spec_.fallocate) {
+            SplitMix content{content_seed};
+            for (auto& word : buffer) {
+                word = content();
+            }
+        }
+        auto const* const data = reinterpret_cast<char const*>(buffer.data());
+#if defined(SCAN_POSIX)
+        int const fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok{true};
+        if (spec_.fallocate && size != 0) {
+            ok = ::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+        }
+        for (std::uint64_t left{spec_.fallocate ? 0 : size}; ok && left != 0;) {
+            auto const n = ::write(fd, data, std::min<std::uint64_t>(left, chunk));
+            ok = n > 0;
+            left -= ok ? static_cast<std::uint64_t>(n) : 0;
+        }
+        return ::close(fd) == 0 && ok;
+#else
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        for (std::uint64_t left{spec_.fallocate ? 0 : size}; out && left != 0;) {
+            auto const n = std::min<std::uint64_t>(left, chunk);
+            out.write(data, static_cast<std::streamsize>(n));
+            left -= n;
+        }
+        out.close();
+        if (out && spec_.fallocate) {
+            std::error_code ec;
+            fs::resize_file(path, size, ec);
+            return !ec;
+        }
+        return static_cast<bool>(out);
+#endif
+    }
+
+    fs::path const root_;
+    TreeSpec const spec_;
+};
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog << " [options] <root>\n"
+              << "  --depth <n>          levels of subdirectories (default 3)\n"
+              << "  --fanout <n>         subdirectories per directory (default 8)\n"
+              << "  --files <n>          files per directory (default 32)\n"
+              << "  --sizes <dist>       fixed:<bytes> | uniform:<min>:<max> |\n"
+              << "                       lognormal:<mu>:<sigma> (default fixed:4096)\n"
+              << "  --symlinks <ratio>   fraction of the files which are symlinks (default 0)\n"
+              << "  --seed <n>           (default 42)\n"
+              << "  --threads <n>\n"
+              << "  --fallocate          allocate the file space instead of writing it\n";
+}
+
+int main(int argc, char* argv[])
+{
+    TreeSpec spec;
+    char const* root_arg{nullptr};
+    for (int i{1}; i < argc; ++i) {
+        std::string_view const arg{argv[i]};
+        bool const has_value = i + 1 < argc;
+        if (arg == "--depth" && has_value) {
+            spec.depth = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--fanout" && has_value) {
+            spec.fanout = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--files" && has_value) {
+            spec.files = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--sizes" && has_value) {
+            if (!SizeDist::parse(argv[++i], spec.sizes)) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg == "--symlinks" && has_value) {
+            spec.symlink_ratio = std::strtod(argv[++i], nullptr);
+        }
+        else if (arg == "--seed" && has_value) {
+            spec.seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--threads" && has_value) {
+            spec.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (arg == "--fallocate") {
+            spec.fallocate = true;
+        }
+        else if (arg.substr(0, 2) != "--" && !root_arg) {
+            root_arg = argv[i];
+        }
+        else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!root_arg || spec.fanout == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        TreeGenerator generator{root_arg, spec};
+        TreeStats stats{spec.threads};
+        auto const start = std::chrono::steady_clock::now();
+        generator.run(stats);
+        std::chrono::duration<double> const elapsed{std::chrono::steady_clock::now() - start};
+        auto const entries = generator.directories() + sum(stats.files) + sum(stats.symlinks);
+        std::cout << "created " << generator.directories() << " directories, " << sum(stats.files)
+                  << " files (" << sum(stats.bytes) << " bytes), " << sum(stats.symlinks)
+                  << " symlinks in " << elapsed.count() << "s ("
+                  << static_cast<double>(entries) / elapsed.count() << " entries/s)\n";
+        if (auto const errors = sum(stats.errors); errors != 0) {
+            std::cerr << errors << " entries could not be created\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (fs::filesystem_error const& e) {
+        std::cerr << "EXCEPTION: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
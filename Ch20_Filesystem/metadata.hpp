@@ -0,0 +1,462 @@
+#if !defined(SCAN_METADATA_H_)
+#define SCAN_METADATA_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "scan.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// IORING_OP_STATX and IORING_OP_OPENAT are enumerators - check for a header at least as new
+#if defined(IORING_FEAT_FAST_POLL)
+#define SCAN_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+/**
+ * Batched metadata calls: statx() and directory opens for many entries at once.
+ *
+ * A synchronous stat() per file keeps one request in flight per thread. On NVMe drives, overlay
+ * and network file systems, most of the time is spent waiting for each result while the device
+ * sits idle. With io_uring the requests of a whole batch are submitted with one system call, and
+ * up to `depth` of them are in flight at once - the kernel completes them asynchronously (with
+ * its own workers where a request would block).
+ *
+ * `Metadata` uses io_uring if asked to and the kernel supports it (Linux 5.6+; the ring is set up
+ * with the raw system calls, liburing isn't needed), and plain synchronous calls otherwise. A ring
+ * isn't thread safe: use one `Metadata` per thread.
+ */
+
+namespace scan {
+
+enum class Backend { sync, uring };
+
+#if defined(SCAN_POSIX)
+inline constexpr int current_dir{AT_FDCWD};
+#else
+inline constexpr int current_dir{-1};   // names are paths
+#endif
+
+struct StatRequest {
+    int dirfd{current_dir};
+    char const* name{nullptr};  // relative to dirfd, has to stay valid until the batch is done
+    unsigned fields{0};
+    Entry entry{};              // result, name and inode are kept if set up front
+    std::error_code ec{};
+};
+
+struct OpenRequest {
+    fs::path const* path{nullptr};
+    Directory dir{};            // result
+    std::error_code ec{};
+};
+
+#if defined(SCAN_URING)
+
+namespace detail {
+
+// The submission and completion queues of an io_uring instance, shared with the kernel.
+class Ring
+{
+public:
+    explicit Ring(unsigned entries) noexcept
+    {
+        if (entries == 0) {
+            return;
+        }
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int const fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return;     // no io_uring - too old a kernel, or disabled (e.g. by seccomp)
+        }
+        fd_ = fd;
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool const single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+        sq_ = map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ = single ? sq_ : map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        auto* const sqes = map(sqes_size_, IORING_OFF_SQES);
+        if (!sq_ || !cq_ || !sqes) {
+            if (sqes) {
+                ::munmap(sqes, sqes_size_);
+            }
+            release();
+            return;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+        sq_tail_ = at<unsigned>(sq_, params.sq_off.tail);
+        sq_mask_ = *at<unsigned>(sq_, params.sq_off.ring_mask);
+        sq_array_ = at<unsigned>(sq_, params.sq_off.array);
+        cq_head_ = at<unsigned>(cq_, params.cq_off.head);
+        cq_tail_ = at<unsigned>(cq_, params.cq_off.tail);
+        cq_mask_ = *at<unsigned>(cq_, params.cq_off.ring_mask);
+        cqes_ = at<io_uring_cqe>(cq_, params.cq_off.cqes);
+        entries_ = params.sq_entries;
+        tail_ = *sq_tail_;
+    }
+
+    Ring(Ring const&) = delete;
+    Ring& operator=(Ring const&) = delete;
+    ~Ring() { close(); }
+
+    // Tears the ring down - requests still in flight are cancelled by the kernel.
+    void close() noexcept
+    {
+        if (sqes_) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        release();
+    }
+
+    explicit operator bool() const noexcept { return sqes_ != nullptr; }
+
+    // Submission queue size - the completion queue is twice as large, so it can't overflow
+    // with at most this many requests in flight.
+    unsigned entries() const noexcept { return entries_; }
+
+    // The next submission queue entry, cleared. Only valid until the next submit().
+    io_uring_sqe& next() noexcept
+    {
+        unsigned const index = tail_++ & sq_mask_;
+        sq_array_[index] = index;
+        auto& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        return sqe;
+    }
+
+    // Publishes the prepared entries to the kernel, and waits for `wait` completions. Returns
+    // 0 or a negative errno.
+    int submit(unsigned wait) noexcept
+    {
+        __atomic_store_n(sq_tail_, tail_, __ATOMIC_RELEASE);
+        unsigned const pending = tail_ - submitted_;
+        for (;;) {
+            auto const n = ::syscall(__NR_io_uring_enter, fd_, pending, wait,
+                                     wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (n >= 0) {
+                submitted_ += static_cast<unsigned>(n);
+                return 0;
+            }
+            if (errno != EINTR) {
+                return -errno;
+            }
+        }
+    }
+
+    // Calls f(io_uring_cqe const&) for each completion available, returns their number.
+    template <typename F>
+    unsigned reap(F&& f)
+    {
+        unsigned head = *cq_head_;
+        unsigned const tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned n{0};
+        for (; head != tail; ++head, ++n) {
+            f(std::as_const(cqes_[head & cq_mask_]));
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return n;
+    }
+
+private:
+    void* map(std::size_t size, unsigned long long offset) noexcept
+    {
+        void* const p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               fd_, static_cast<off_t>(offset));
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    void release() noexcept
+    {
+        if (cq_ && cq_ != sq_) {
+            ::munmap(cq_, cq_size_);
+        }
+        if (sq_) {
+            ::munmap(sq_, sq_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        sq_ = cq_ = nullptr;
+        sqes_ = nullptr;
+        fd_ = -1;
+    }
+
+    template <typename T>
+    static T* at(void* base, unsigned offset) noexcept
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    int fd_{-1};
+    void* sq_{nullptr};
+    void* cq_{nullptr};
+    std::size_t sq_size_{0};
+    std::size_t cq_size_{0};
+    std::size_t sqes_size_{0};
+    io_uring_sqe* sqes_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned* sq_array_{nullptr};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+    unsigned entries_{0};
+    unsigned tail_{0};          // local submission tail, published by submit()
+    unsigned submitted_{0};     // entries consumed by the kernel
+};
+
+} // namespace detail
+
+#endif // SCAN_URING
+
+class Metadata
+{
+public:
+    explicit Metadata(Backend backend = Backend::sync, unsigned depth = 256)
+#if defined(SCAN_URING)
+        : ring_{backend == Backend::uring ? depth : 0u}
+#endif
+    {
+        (void)backend;
+        (void)depth;
+#if defined(SCAN_URING)
+        if (ring_) {
+            statx_.resize(ring_.entries());
+            request_.assign(ring_.entries(), none);
+            for (unsigned slot{0}; slot < ring_.entries(); ++slot) {
+                free_.push_back(slot);
+            }
+        }
+#endif
+    }
+
+    // Whether requests are really submitted to io_uring.
+    bool async() const noexcept
+    {
+#if defined(SCAN_URING)
+        return static_cast<bool>(ring_);
+#else
+        return false;
+#endif
+    }
+
+    // The io_uring error after which all requests were made with synchronous calls, if any.
+    std::error_code error() const noexcept { return error_; }
+
+    // Fills `entry` and `ec` of each request. A missing file is reported as type `not_found`,
+    // other errors as `unknown`, like scan::stat().
+    void stat(StatRequest* requests, std::size_t n)
+    {
+        auto const sync = [](StatRequest& r) {
+#if defined(SCAN_POSIX)
+            r.ec = detail::stat_at(r.dirfd, r.name, r.fields, r.entry);
+            if (r.ec) {
+                r.entry.type = error_type(r.ec);
+            }
+#else
+            r.entry = scan::stat(r.name, r.fields, r.ec);
+#endif
+        };
+#if defined(SCAN_URING)
+        if (async()) {
+            run(n,
+                [&](io_uring_sqe& sqe, std::size_t i, unsigned slot) {
+                    auto const& r = requests[i];
+                    sqe.opcode = IORING_OP_STATX;
+                    sqe.fd = r.dirfd;
+                    sqe.addr = reinterpret_cast<std::uintptr_t>(r.name);
+                    sqe.len = detail::statx_mask(r.fields);
+                    sqe.off = reinterpret_cast<std::uintptr_t>(&statx_[slot]);
+                    sqe.statx_flags = static_cast<std::uint32_t>(detail::stat_flags(r.fields)
+                                                                 | AT_STATX_DONT_SYNC);
+                },
+                [&](std::size_t i, unsigned slot, int res) {
+                    auto& r = requests[i];
+                    if (res == -EINVAL) {   // opcode not supported by this kernel
+                        sync(r);
+                        return;
+                    }
+                    if (res < 0) {
+                        r.ec.assign(-res, std::generic_category());
+                        r.entry.type = error_type(r.ec);
+                    }
+                    else {
+                        r.ec.clear();
+                        detail::from_statx(statx_[slot], r.entry);
+                    }
+                },
+                [&](std::size_t i) { sync(requests[i]); });
+            return;
+        }
+#endif
+        for (std::size_t i{0}; i < n; ++i) {
+            sync(requests[i]);
+        }
+    }
+
+    // Opens the directories of all requests, like Directory::open().
+    void open(OpenRequest* requests, std::size_t n)
+    {
+#if defined(SCAN_URING)
+        if (async()) {
+            run(n,
+                [&](io_uring_sqe& sqe, std::size_t i, unsigned) {
+                    sqe.opcode = IORING_OP_OPENAT;
+                    sqe.fd = AT_FDCWD;
+                    sqe.addr = reinterpret_cast<std::uintptr_t>(requests[i].path->c_str());
+                    sqe.open_flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+                },
+                [&](std::size_t i, unsigned, int res) {
+                    auto& r = requests[i];
+                    if (res == -EINVAL) {
+                        r.dir = Directory::open(*r.path, r.ec);
+                    }
+                    else if (res < 0) {
+                        r.ec.assign(-res, std::generic_category());
+                    }
+                    else {
+                        r.dir = Directory::adopt(res, r.ec);
+                    }
+                },
+                [&](std::size_t i) {
+                    requests[i].dir = Directory::open(*requests[i].path, requests[i].ec);
+                });
+            return;
+        }
+#endif
+        for (std::size_t i{0}; i < n; ++i) {
+            requests[i].dir = Directory::open(*requests[i].path, requests[i].ec);
+        }
+    }
+
+    // Like dir.for_each(fields, f), but with io_uring the entries of the directory are read
+    // first, and all those which need a stat() are stat()ed in one batch.
+    template <typename F>
+    std::error_code for_each(Directory const& dir, unsigned fields, F&& f)
+    {
+#if defined(SCAN_URING)
+        if (async()) {
+            names_.clear();
+            offsets_.clear();
+            entries_.clear();
+            requests_.clear();
+            index_.clear();
+            auto const ec = dir.for_each(0, [&](Entry const& e) {
+                offsets_.push_back(names_.size());
+                names_.append(e.name).push_back('\0');
+                entries_.push_back(e);
+            });
+            bool const all = (fields & (field::mtime | field::dev)) != 0;
+            for (std::size_t i{0}; i < entries_.size(); ++i) {
+                auto& e = entries_[i];
+                e.name = std::string_view{names_.data() + offsets_[i], e.name.size()};
+                if (all || detail::needs_stat(fields, e)) {
+                    requests_.push_back(StatRequest{dir.fd(), e.name.data(), fields, e});
+                    index_.push_back(i);
+                }
+            }
+            stat(requests_.data(), requests_.size());
+            for (std::size_t i{0}; i < requests_.size(); ++i) {
+                auto& e = entries_[index_[i]];
+                e = requests_[i].entry;
+                detail::stat_done(fields, requests_[i].ec, e);
+            }
+            for (auto const& e : entries_) {
+                f(e);
+            }
+            return ec;
+        }
+#endif
+        return dir.for_each(fields, std::forward<F>(f));
+    }
+
+private:
+#if defined(SCAN_URING)
+    // Keeps up to ring_.entries() requests in flight: prep(sqe, i, slot) prepares request i,
+    // which may use the buffer `slot`, done(i, slot, res) handles its completion. If io_uring
+    // fails, the error is kept in error_, the ring is closed, and redo(i) makes each request
+    // which didn't complete with a synchronous call - so do all later ones, as async() is false.
+    template <typename Prep, typename Done, typename Redo>
+    void run(std::size_t n, Prep&& prep, Done&& done, Redo&& redo)
+    {
+        std::size_t next{0};
+        std::size_t in_flight{0};
+        while (next < n || in_flight > 0) {
+            while (next < n && !free_.empty()) {
+                auto const slot = free_.back();
+                free_.pop_back();
+                auto& sqe = ring_.next();
+                prep(sqe, next, slot);
+                sqe.user_data = (std::uint64_t{next} << 32) | slot;
+                request_[slot] = next;
+                ++next;
+                ++in_flight;
+            }
+            if (int const err = ring_.submit(1); err < 0 && err != -EAGAIN && err != -EBUSY) {
+                error_.assign(-err, std::generic_category());
+                fall_back(next, n, redo);
+                return;
+            }
+            in_flight -= ring_.reap([&](io_uring_cqe const& cqe) {
+                auto const slot = static_cast<unsigned>(cqe.user_data & 0xffffffffu);
+                auto const i = static_cast<std::size_t>(cqe.user_data >> 32);
+                done(i, slot, cqe.res);
+                request_[slot] = none;
+                free_.push_back(slot);
+            });
+        }
+    }
+
+    // Closes the ring after a failure, and redoes the requests still in flight, and those from
+    // `next` on, which weren't submitted yet.
+    template <typename Redo>
+    void fall_back(std::size_t next, std::size_t n, Redo&& redo)
+    {
+        ring_.close();
+        for (auto& i : request_) {
+            if (i != none) {
+                redo(i);
+                i = none;
+            }
+        }
+        for (; next < n; ++next) {
+            redo(next);
+        }
+    }
+
+    static constexpr std::size_t none{std::numeric_limits<std::size_t>::max()};
+
+    detail::Ring ring_;
+    std::vector<struct statx> statx_{};     // one result buffer per request in flight
+    std::vector<unsigned> free_{};          // free buffers
+    std::vector<std::size_t> request_{};    // of each buffer in flight, `none` if free
+    // buffers of for_each(), reused for each directory
+    std::string names_{};
+    std::vector<std::size_t> offsets_{};
+    std::vector<Entry> entries_{};
+    std::vector<StatRequest> requests_{};
+    std::vector<std::size_t> index_{};      // entry of each request
+#endif
+    std::error_code error_{};
+};
+
+} // namespace scan
+
+#endif // SCAN_METADATA_H_
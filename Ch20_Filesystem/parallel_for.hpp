@@ -0,0 +1,33 @@
+#if !defined(PARALLEL_FOR_H_)
+#define PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls f(i) for i in [0, n) on up to `threads` threads (the calling one included). Each thread
+// takes the next index from a shared counter, so uneven work items (files of very different
+// sizes) balance out.
+template <typename F>
+void parallel_for_index(std::size_t n, std::size_t threads, F f)
+{
+    std::atomic<std::size_t> next{0};
+    auto const worker = [&] {
+        for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < n;
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            f(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t i{1}; i < std::min(threads, n); ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+#endif // PARALLEL_FOR_H_
@@ -0,0 +1,232 @@
+#if !defined(PARALLEL_WALK_H_)
+#define PARALLEL_WALK_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <per_thread.hpp>
+#include <profiler.hpp>
+#include "metadata.hpp"
+#include "scan.hpp"
+#include "visited_set.hpp"
+
+/**
+ * A parallel directory tree walker.
+ *
+ * Instead of collecting all the paths of a tree up front (like copying a
+ * recursive_directory_iterator into a vector) and then processing them, the walker keeps a queue
+ * of directories only. Each worker takes a directory from the queue, iterates over it, hands each
+ * entry to the callback as it goes, and pushes the subdirectories back onto the queue. Memory use
+ * is bounded by the number of directories waiting to be scanned, not by the number of files.
+ *
+ * Directories are read with scan::Directory (see scan.hpp): the callback gets the path of the
+ * directory and a compact scan::Entry for each of its entries. The type comes from readdir()
+ * wherever the file system provides it, further metadata (WalkOptions::fields) is fetched with
+ * one statx() relative to the open directory - unlike is_directory(path), file_size(path), ...
+ * which each stat() the full path again. The callback is called concurrently from all workers.
+ *
+ * With WalkOptions::backend = Backend::uring each worker submits its metadata calls to its own
+ * io_uring (see metadata.hpp): it takes several directories from the queue at once and opens them
+ * with one submission, and stats all entries of a directory in one batch.
+ *
+ * With WalkOptions::unique, the workers share a VisitedSet (see visited_set.hpp): a directory
+ * whose (dev, ino) was seen before is skipped unread, and a regular file reached by a second name
+ * (hard link, or symlink with scan::field::follow) isn't reported again. That's what makes
+ * WalkOptions::follow_symlinks safe, which implies it. A directory costs one statx() more for its
+ * identity; files are only tracked if they can have another name, i.e. with more than one link
+ * or if symlinks to files are followed.
+ */
+
+namespace fs = std::filesystem;
+
+struct WalkOptions {
+    std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+    unsigned fields{scan::field::type};     // metadata needed by the callback, see scan::field
+    scan::Backend backend{scan::Backend::sync};
+    unsigned queue_depth{256};              // requests in flight per worker with io_uring
+    bool unique{false};             // each directory and regular file once, by (dev, inode)
+    bool follow_symlinks{false};    // descend into symlinks to directories, implies `unique`
+};
+
+class WalkQueue
+{
+public:
+    void push(fs::path dir)
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            dirs_.push_back(std::move(dir));
+            ++pending_;
+        }
+        cv_.notify_one();
+    }
+
+    // Blocks until there's a directory to scan, and takes up to `max` directories. Returns
+    // false once the whole tree is done.
+    bool pop(std::vector<fs::path>& dirs, std::size_t max)
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        cv_.wait(lock, [this] { return !dirs_.empty() || pending_ == 0; });
+        dirs.clear();
+        while (!dirs_.empty() && dirs.size() < max) {
+            dirs.push_back(std::move(dirs_.front()));
+            dirs_.pop_front();
+        }
+        return !dirs.empty();
+    }
+
+    // Has to be called once for each popped directory, after its subdirectories were pushed.
+    void done()
+    {
+        bool finished{false};
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            finished = --pending_ == 0;
+        }
+        if (finished) {
+            cv_.notify_all();
+        }
+    }
+
+private:
+    std::mutex mutex_{};
+    std::condition_variable cv_{};
+    std::deque<fs::path> dirs_{};
+    std::size_t pending_{0};    // directories queued or being scanned
+};
+
+// Totals of the regular files directly in one directory.
+struct DirTotals {
+    std::uintmax_t files{0};
+    std::uintmax_t bytes{0};
+};
+
+// Calls on_entry(dir, entry) for every entry below `root`, `dir` being the path of the directory
+// containing `entry`, and on_directory(dir, own) once each directory is read, with the totals of
+// its regular files (sizes are only known with scan::field::size). Directory symlinks are
+// reported, and only followed with WalkOptions::follow_symlinks. Returns the number of
+// directories which couldn't be read.
+template <typename OnEntry, typename OnDirectory>
+std::uintmax_t parallel_walk(fs::path const& root, WalkOptions const& opts, OnEntry&& on_entry,
+                             OnDirectory&& on_directory)
+{
+    WalkQueue queue;
+    std::atomic<std::uintmax_t> errors{0};
+    VisitedSet visited;
+    bool const unique = opts.unique || opts.follow_symlinks;
+    auto fields = opts.fields | scan::field::type;
+    if (opts.follow_symlinks) {
+        fields |= scan::field::follow;
+    }
+    if (unique) {
+        fields |= scan::field::ino | scan::field::nlink;
+    }
+    // a second name of a file: another hard link, or a symlink to it
+    bool const all_files = (fields & scan::field::follow) != 0;
+    auto const seen = [&](scan::Entry const& e) {
+        return (all_files || e.nlink > 1) && e.ino != 0 && !visited.insert(e.dev, e.ino);
+    };
+    queue.push(root);
+
+    auto const worker = [&] {
+        scan::Metadata metadata{opts.backend, opts.queue_depth};
+        std::size_t const batch = metadata.async() ? 16 : 1;
+        std::vector<fs::path> dirs;
+        std::vector<scan::OpenRequest> opens;
+        std::uintmax_t failed{0};   // added up once the worker is done
+        while (queue.pop(dirs, batch)) {
+            opens.clear();
+            opens.resize(dirs.size());
+            for (std::size_t i{0}; i < dirs.size(); ++i) {
+                opens[i].path = &dirs[i];
+            }
+            metadata.open(opens.data(), opens.size());
+            for (std::size_t i{0}; i < dirs.size(); ++i) {
+                ProfileZone zone{"scan directory"};
+                auto const& dir = dirs[i];
+                auto ec = opens[i].ec;
+                DirTotals own;
+                if (opens[i].dir && unique) {
+                    std::error_code self_ec;
+                    auto const self = opens[i].dir.self(scan::field::ino, self_ec);
+                    if (!self_ec && self.ino != 0 && !visited.insert(self.dev, self.ino)) {
+                        opens[i].dir = {};      // reached before, by another path
+                    }
+                }
+                if (opens[i].dir) {
+                    ec = metadata.for_each(opens[i].dir, fields, [&](scan::Entry const& entry) {
+                        if (entry.type == fs::file_type::regular && unique && seen(entry)) {
+                            return;
+                        }
+                        on_entry(dir, entry);
+                        if (entry.type == fs::file_type::regular) {
+                            ++own.files;
+                            own.bytes += entry.size;
+                        }
+                        else if (entry.type == fs::file_type::directory
+                                 && (!entry.symlink || opts.follow_symlinks)) {
+                            queue.push(dir / entry.name);
+                        }
+                    });
+                }
+                if (ec) {
+                    ++failed;
+                }
+                on_directory(dir, std::as_const(own));
+                queue.done();
+            }
+        }
+        errors.fetch_add(failed, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i{1}; i < opts.threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+    return errors.load(std::memory_order_relaxed);
+}
+
+template <typename OnEntry>
+std::uintmax_t parallel_walk(fs::path const& root, WalkOptions const& opts, OnEntry&& on_entry)
+{
+    return parallel_walk(root, opts, std::forward<OnEntry>(on_entry),
+                         [](fs::path const&, DirTotals const&) { });
+}
+
+struct DirSize {
+    std::uintmax_t files{0};
+    std::uintmax_t bytes{0};
+    std::uintmax_t errors{0};
+};
+
+// Total size of the regular files below `root` (including symlinks to regular files, like
+// is_regular_file(path) + file_size(path), unless WalkOptions::unique counts each file once).
+// The per-thread counters are summed up at the end.
+inline DirSize parallel_dirsize(fs::path const& root, WalkOptions opts = {})
+{
+    per_thread_counter<std::uintmax_t> files{opts.threads + 1};
+    per_thread_counter<std::uintmax_t> bytes{opts.threads + 1};
+    opts.fields |= scan::field::size | scan::field::follow;
+    auto const errors = parallel_walk(root, opts, [&](fs::path const&, scan::Entry const& entry) {
+        if (entry.type == fs::file_type::regular) {
+            add(files, 1);
+            add(bytes, entry.size);
+        }
+    });
+    return DirSize{sum(files), sum(bytes), errors};
+}
+
+#endif // PARALLEL_WALK_H_
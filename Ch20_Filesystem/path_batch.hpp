@@ -0,0 +1,238 @@
+#if !defined(PATH_BATCH_H_)
+#define PATH_BATCH_H_
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "metadata.hpp"
+#include "scan.hpp"
+
+/**
+ * Classifies many paths at once - e.g. a list of millions of paths to validate - instead of one
+ * process per path.
+ *
+ * The paths are read as a whole (newline or NUL separated), split into one contiguous range per
+ * thread, and each thread:
+ * - stats its paths relative to an open file descriptor of their parent directory, so the kernel
+ *   resolves each parent only once for all its entries (the descriptors are cached per thread),
+ * - submits the stats in batches through a scan::Metadata, i.e. with io_uring if requested,
+ * - formats its results into its own buffer, with to_chars.
+ * The buffers are written in input order, with one write per thread. Each line is
+ *     <type> TAB <size> TAB <path>
+ * with the type as in std::filesystem::file_type (following symlinks, like status()), and the
+ * size for regular files only.
+ */
+
+namespace batch {
+
+namespace fs = std::filesystem;
+
+struct Options {
+    char separator{'\n'};   // of input and output, '\0' for NUL-separated lists
+    std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+    scan::Backend backend{scan::Backend::sync};
+};
+
+inline char const* type_name(fs::file_type type) noexcept
+{
+    switch (type) {
+    case fs::file_type::regular: return "regular";
+    case fs::file_type::directory: return "directory";
+    case fs::file_type::symlink: return "symlink";
+    case fs::file_type::block: return "block";
+    case fs::file_type::character: return "character";
+    case fs::file_type::fifo: return "fifo";
+    case fs::file_type::socket: return "socket";
+    case fs::file_type::not_found: return "not_found";
+    default: return "unknown";
+    }
+}
+
+// Reads all of `file` ("-" for stdin). Returns false if it can't be read.
+inline bool read_all(char const* file, std::string& data)
+{
+    std::FILE* const in = std::strcmp(file, "-") == 0 ? stdin : std::fopen(file, "rb");
+    if (!in) {
+        return false;
+    }
+    constexpr std::size_t chunk{1 << 20};
+    for (;;) {
+        auto const size = data.size();
+        data.resize(size + chunk);
+        auto const n = std::fread(data.data() + size, 1, chunk, in);
+        data.resize(size + n);
+        if (n < chunk) {
+            break;
+        }
+    }
+    bool const ok = !std::ferror(in);
+    if (in != stdin) {
+        std::fclose(in);
+    }
+    return ok;
+}
+
+// Splits `data` into paths, terminating each with '\0' in place. Empty lines are skipped.
+inline std::vector<char const*> split(std::string& data, char separator)
+{
+    std::vector<char const*> paths;
+    data.push_back(separator);
+    std::size_t begin{0};
+    for (auto end = data.find(separator); end != data.npos; end = data.find(separator, begin)) {
+        data[end] = '\0';
+        if (end != begin) {
+            paths.push_back(data.data() + begin);
+        }
+        begin = end + 1;
+    }
+    return paths;
+}
+
+namespace detail {
+
+// The open parent directories of one thread.
+class DirCache
+{
+public:
+    DirCache() = default;
+    DirCache(DirCache const&) = delete;
+    DirCache& operator=(DirCache const&) = delete;
+    ~DirCache() { clear(); }
+
+    // The descriptor of directory `dir`, or -1 if it can't be opened.
+    int get(std::string_view dir)
+    {
+        key_.assign(dir);
+        auto const pos = fds_.find(key_);
+        if (pos != fds_.end()) {
+            return pos->second;
+        }
+#if defined(SCAN_POSIX)
+        int const fd = ::open(key_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#else
+        int const fd = -1;
+#endif
+        fds_.emplace(key_, fd);
+        return fd;
+    }
+
+    std::size_t size() const noexcept { return fds_.size(); }
+
+    void clear() noexcept
+    {
+        for (auto const& [dir, fd] : fds_) {
+            if (fd >= 0) {
+#if defined(SCAN_POSIX)
+                ::close(fd);
+#endif
+            }
+        }
+        fds_.clear();
+    }
+
+private:
+    std::unordered_map<std::string, int> fds_{};
+    std::string key_{};
+};
+
+inline void classify_range(char const* const* paths, std::size_t n, Options const& opts,
+                           std::string& out)
+{
+    constexpr std::size_t batch_size{256};
+    // keep well below the usual limit of 1024 open files, for all threads together
+    auto const max_open = std::max<std::size_t>(16, 512 / opts.threads);
+    unsigned const fields{scan::field::type | scan::field::size | scan::field::follow};
+    scan::Metadata metadata{opts.backend, batch_size};
+    DirCache dirs;
+    std::vector<scan::StatRequest> requests;
+    for (std::size_t first{0}, last{0}; first < n; first = last) {
+        // descriptors are only closed between batches, while no request refers to them
+        if (dirs.size() >= max_open) {
+            dirs.clear();
+        }
+        requests.clear();
+        for (; last < n && last - first < batch_size && dirs.size() < max_open; ++last) {
+            auto& r = requests.emplace_back();
+            r.fields = fields;
+            r.name = paths[last];
+            std::string_view const path{paths[last]};
+            auto const slash = path.rfind('/');
+            // "name", "/name" and "dir/" are stat()ed as they are
+            if (slash != path.npos && slash != 0 && slash + 1 != path.size()) {
+                int const fd = dirs.get(path.substr(0, slash));
+                if (fd >= 0) {
+                    r.dirfd = fd;
+                    r.name = paths[last] + slash + 1;
+                }
+            }
+        }
+        metadata.stat(requests.data(), requests.size());
+        for (std::size_t i{first}; i < last; ++i) {
+            auto const& e = requests[i - first].entry;
+            out += type_name(e.type);
+            out += '\t';
+            if (e.type == fs::file_type::regular) {
+                char digits[24];
+                auto const end = std::to_chars(digits, digits + sizeof(digits), e.size).ptr;
+                out.append(digits, end);
+            }
+            out += '\t';
+            out += paths[i];
+            out += opts.separator;
+        }
+    }
+}
+
+} // namespace detail
+
+// Classifies all `paths` and writes one line per path to `out`, in input order.
+inline void classify(std::vector<char const*> const& paths, Options const& opts, std::FILE* out)
+{
+    // below a few thousand paths, starting threads costs more than it saves
+    auto const threads = std::clamp<std::size_t>(paths.size() / 4096, 1, opts.threads);
+    std::vector<std::string> buffers(threads);
+    std::vector<std::thread> workers;
+    auto const range = [&](std::size_t t) {
+        auto const first = paths.size() * t / threads;
+        auto const last = paths.size() * (t + 1) / threads;
+        detail::classify_range(paths.data() + first, last - first, opts, buffers[t]);
+    };
+    for (std::size_t t{1}; t < threads; ++t) {
+        workers.emplace_back(range, t);
+    }
+    range(0);
+    for (std::size_t t{0}; t < threads; ++t) {
+        if (t != 0) {
+            workers[t - 1].join();
+        }
+        std::fwrite(buffers[t].data(), 1, buffers[t].size(), out);
+    }
+    std::fflush(out);
+}
+
+// Reads the paths from `file` ("-" for stdin) and writes their classification to stdout.
+// Returns an exit status.
+inline int run(char const* file, Options const& opts)
+{
+    std::string data;
+    if (!read_all(file, data)) {
+        std::perror(file);
+        return EXIT_FAILURE;
+    }
+    classify(split(data, opts.separator), opts, stdout);
+    return EXIT_SUCCESS;
+}
+
+} // namespace batch
+
+#endif // PATH_BATCH_H_
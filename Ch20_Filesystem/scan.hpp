@@ -0,0 +1,377 @@
+#if !defined(SCAN_H_)
+#define SCAN_H_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SCAN_POSIX 1
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Directory scanning with as few metadata syscalls as possible.
+ *
+ * Every free function query on a plain path - is_regular_file(p), file_size(p), is_directory(p),
+ * exists(p) - is a separate stat() of the full path. On cold caches and network file systems these
+ * calls dominate the time of a scan. This API instead:
+ * - keeps the type readdir() already returns in d_type, and the inode number from d_ino,
+ * - only stats an entry if the caller asked for a field readdir() can't provide (or the file system
+ *   doesn't fill d_type), and then with a single statx() relative to the open directory, asking
+ *   only for the requested fields (other fields may be expensive, e.g. on network file systems),
+ * - hands out a compact `Entry` record per directory entry.
+ *
+ * On non-POSIX platforms the same interface is implemented with std::filesystem.
+ */
+
+namespace scan {
+
+namespace fs = std::filesystem;
+
+// The metadata a caller needs from each entry, combined with | - type and inode come for free
+// from readdir() (on most file systems).
+namespace field {
+enum : unsigned {
+    type = 1u << 0,
+    size = 1u << 1,
+    mtime = 1u << 2,
+    dev = 1u << 3,
+    ino = 1u << 4,
+    follow = 1u << 5,   // report type and size of the target of symlinks
+    nlink = 1u << 6,
+};
+} // namespace field
+
+struct Entry {
+    std::string_view name{};    // valid during the callback only, null-terminated
+    std::uint64_t ino{0};
+    std::uint64_t dev{0};
+    std::uint64_t size{0};
+    std::int64_t mtime_ns{0};
+    std::uint32_t nlink{0};
+    fs::file_type type{fs::file_type::unknown};
+    bool symlink{false};        // the entry itself is a symlink (type is the target's with `follow`)
+};
+
+// The type of a path which couldn't be stat()ed: `not_found` if it doesn't exist, or a component
+// of it isn't a directory (ENOENT, ENOTDIR - like fs::status()), otherwise `unknown` - then `ec`
+// is a real error, e.g. a symlink loop or no permission.
+inline fs::file_type error_type(std::error_code const& ec) noexcept
+{
+    return ec == std::errc::no_such_file_or_directory || ec == std::errc::not_a_directory
+               ? fs::file_type::not_found
+               : fs::file_type::unknown;
+}
+
+#if defined(SCAN_POSIX)
+
+namespace detail {
+
+inline fs::file_type from_mode(unsigned mode) noexcept
+{
+    switch (mode & S_IFMT) {
+    case S_IFREG: return fs::file_type::regular;
+    case S_IFDIR: return fs::file_type::directory;
+    case S_IFLNK: return fs::file_type::symlink;
+    case S_IFBLK: return fs::file_type::block;
+    case S_IFCHR: return fs::file_type::character;
+    case S_IFIFO: return fs::file_type::fifo;
+    case S_IFSOCK: return fs::file_type::socket;
+    default: return fs::file_type::unknown;
+    }
+}
+
+inline fs::file_type from_dtype(unsigned char d_type) noexcept
+{
+    switch (d_type) {
+    case DT_REG: return fs::file_type::regular;
+    case DT_DIR: return fs::file_type::directory;
+    case DT_LNK: return fs::file_type::symlink;
+    case DT_BLK: return fs::file_type::block;
+    case DT_CHR: return fs::file_type::character;
+    case DT_FIFO: return fs::file_type::fifo;
+    case DT_SOCK: return fs::file_type::socket;
+    default: return fs::file_type::unknown;
+    }
+}
+
+inline int stat_flags(unsigned fields) noexcept
+{
+    return (fields & field::follow) ? 0 : AT_SYMLINK_NOFOLLOW;
+}
+
+#if defined(STATX_TYPE)
+inline unsigned statx_mask(unsigned fields) noexcept
+{
+    unsigned mask{STATX_TYPE};
+    if (fields & field::size) { mask |= STATX_SIZE; }
+    if (fields & field::mtime) { mask |= STATX_MTIME; }
+    if (fields & field::ino) { mask |= STATX_INO; }
+    if (fields & field::nlink) { mask |= STATX_NLINK; }
+    return mask;
+}
+
+inline void from_statx(struct statx const& stx, Entry& e) noexcept
+{
+    e.type = from_mode(stx.stx_mode);
+    e.size = stx.stx_size;
+    e.mtime_ns = static_cast<std::int64_t>(stx.stx_mtime.tv_sec) * 1'000'000'000
+                 + stx.stx_mtime.tv_nsec;
+    e.ino = stx.stx_ino;
+    e.dev = (std::uint64_t{stx.stx_dev_major} << 32) | stx.stx_dev_minor;
+    e.nlink = stx.stx_nlink;
+}
+#endif
+
+// Fill the requested fields of `e` with one stat call, relative to `dirfd` (AT_FDCWD for paths).
+inline std::error_code stat_at(int dirfd, char const* name, unsigned fields, Entry& e) noexcept
+{
+    int const flags = stat_flags(fields);
+#if defined(STATX_TYPE)
+    struct statx stx;
+    // don't force a network file system to revalidate its cached attributes
+    if (::statx(dirfd, name, flags | AT_STATX_DONT_SYNC, statx_mask(fields), &stx) != 0) {
+        return {errno, std::generic_category()};
+    }
+    from_statx(stx, e);
+#else
+    struct stat st;
+    if (::fstatat(dirfd, name, &st, flags) != 0) {
+        return {errno, std::generic_category()};
+    }
+    e.type = from_mode(st.st_mode);
+    e.size = static_cast<std::uint64_t>(st.st_size);
+    e.mtime_ns = static_cast<std::int64_t>(st.st_mtime) * 1'000'000'000;
+    e.ino = static_cast<std::uint64_t>(st.st_ino);
+    e.dev = static_cast<std::uint64_t>(st.st_dev);
+    e.nlink = static_cast<std::uint32_t>(st.st_nlink);
+#endif
+    return {};
+}
+
+// Whether an entry as read from readdir() has to be stat()ed for the requested fields (beyond
+// mtime and dev, which readdir() never provides).
+inline bool needs_stat(unsigned fields, Entry const& e) noexcept
+{
+    // the size and link count of a directory are meaningless, don't stat them for it
+    return ((fields & (field::size | field::nlink)) && e.type != fs::file_type::directory)
+           || ((fields & field::type) && e.type == fs::file_type::unknown)
+           || (e.symlink && (fields & field::follow));
+}
+
+// Completes an entry after its stat: entries which vanished or can't be stat()ed are reported
+// with type `unknown`, resolved symlinks keep their `symlink` flag.
+inline void stat_done(unsigned fields, std::error_code const& ec, Entry& e) noexcept
+{
+    if (ec) {
+        e.type = fs::file_type::unknown;
+    }
+    else if (!(e.symlink && (fields & field::follow))) {
+        e.symlink = e.type == fs::file_type::symlink;
+    }
+}
+
+} // namespace detail
+
+// An open directory. Entries are stat()ed relative to its file descriptor, so the kernel doesn't
+// have to resolve the full path again for every entry.
+class Directory
+{
+public:
+    Directory() = default;
+
+    static Directory open(fs::path const& path, std::error_code& ec) noexcept
+    {
+        return Directory{::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC), ec};
+    }
+
+    // Takes over a directory file descriptor opened elsewhere, e.g. asynchronously.
+    static Directory adopt(int fd, std::error_code& ec) noexcept { return Directory{fd, ec}; }
+
+    // Opens the subdirectory `name` (as reported by for_each()) of this directory.
+    Directory open_at(char const* name, std::error_code& ec) const noexcept
+    {
+        return Directory{::openat(fd(), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC),
+                         ec};
+    }
+
+    Directory(Directory&& other) noexcept : dir_{std::exchange(other.dir_, nullptr)} { }
+    Directory& operator=(Directory&& other) noexcept
+    {
+        std::swap(dir_, other.dir_);
+        return *this;
+    }
+    Directory(Directory const&) = delete;
+    Directory& operator=(Directory const&) = delete;
+    ~Directory()
+    {
+        if (dir_) {
+            ::closedir(dir_);
+        }
+    }
+
+    explicit operator bool() const noexcept { return dir_ != nullptr; }
+    int fd() const noexcept { return ::dirfd(dir_); }
+
+    // Stats the open directory itself, e.g. for its device and inode.
+    Entry self(unsigned fields, std::error_code& ec) const noexcept
+    {
+        Entry e;
+        ec = detail::stat_at(fd(), ".", fields, e);
+        return e;
+    }
+
+    // Calls f(Entry const&) for each entry except "." and "..". `fields` selects the information
+    // needed, only entries for which readdir() can't provide it are stat()ed (size is only
+    // provided for non-directories). Entries which
+    // vanish or can't be stat()ed are reported with type `unknown`. Returns the first error of
+    // reading the directory itself.
+    template <typename F>
+    std::error_code for_each(unsigned fields, F&& f) const
+    {
+        ::rewinddir(dir_);
+        bool const need_stat = (fields & (field::mtime | field::dev)) != 0;
+        for (;;) {
+            errno = 0;
+            auto const* const d = ::readdir(dir_);
+            if (!d) {
+                if (errno != 0) {
+                    return {errno, std::generic_category()};
+                }
+                return {};
+            }
+            std::string_view const name{d->d_name};
+            if (name == "." || name == "..") {
+                continue;
+            }
+            Entry e;
+            e.name = name;
+            e.ino = static_cast<std::uint64_t>(d->d_ino);
+            e.type = detail::from_dtype(d->d_type);
+            e.symlink = e.type == fs::file_type::symlink;
+            if (need_stat || detail::needs_stat(fields, e)) {
+                detail::stat_done(fields, detail::stat_at(fd(), d->d_name, fields, e), e);
+            }
+            f(std::as_const(e));
+        }
+    }
+
+private:
+    Directory(int fd, std::error_code& ec) noexcept
+    {
+        if (fd < 0) {
+            ec.assign(errno, std::generic_category());
+            return;
+        }
+        dir_ = ::fdopendir(fd);
+        if (!dir_) {
+            ec.assign(errno, std::generic_category());
+            ::close(fd);
+            return;
+        }
+        ec.clear();
+    }
+
+    DIR* dir_{nullptr};
+};
+
+// Stat a single path, e.g. a command line argument. With field::follow this behaves like
+// status(), otherwise like symlink_status(). A missing path is reported as type `not_found`,
+// other errors as `unknown`, see error_type().
+inline Entry stat(fs::path const& path, unsigned fields, std::error_code& ec) noexcept
+{
+    Entry e;
+    ec = detail::stat_at(AT_FDCWD, path.c_str(), fields, e);
+    if (ec) {
+        e.type = error_type(ec);
+    }
+    return e;
+}
+
+#else // !SCAN_POSIX
+
+// std::filesystem fallback - the directory_entry caches what the platform provides.
+class Directory
+{
+public:
+    Directory() = default;
+
+    static Directory open(fs::path const& path, std::error_code& ec)
+    {
+        Directory d;
+        if (fs::is_directory(path, ec)) {
+            d.path_ = path;
+        }
+        else if (!ec) {
+            ec = std::make_error_code(std::errc::not_a_directory);
+        }
+        return d;
+    }
+
+    Directory open_at(char const* name, std::error_code& ec) const
+    {
+        return open(path_ / name, ec);
+    }
+
+    explicit operator bool() const noexcept { return !path_.empty(); }
+
+    // Device and inode aren't available here, they stay 0.
+    Entry self(unsigned fields, std::error_code& ec) const
+    {
+        return scan::stat(path_, fields | field::follow, ec);
+    }
+
+    template <typename F>
+    std::error_code for_each(unsigned fields, F&& f) const
+    {
+        std::error_code ec;
+        for (fs::directory_iterator pos{path_, ec}, end; !ec && pos != end; pos.increment(ec)) {
+            auto const& de = *pos;
+            std::error_code entry_ec;
+            auto const name = de.path().filename().string();
+            Entry e;
+            e.name = name;
+            e.symlink = de.is_symlink(entry_ec);
+            e.type = (e.symlink && !(fields & field::follow)) ? fs::file_type::symlink
+                                                       : de.status(entry_ec).type();
+            if ((fields & field::size) && e.type == fs::file_type::regular) {
+                e.size = de.file_size(entry_ec);
+            }
+            if (fields & field::mtime) {
+                e.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 de.last_write_time(entry_ec).time_since_epoch())
+                                 .count();
+            }
+            f(std::as_const(e));
+        }
+        return ec;
+    }
+
+private:
+    fs::path path_{};
+};
+
+inline Entry stat(fs::path const& path, unsigned fields, std::error_code& ec)
+{
+    Entry e;
+    auto const st = (fields & field::follow) ? fs::status(path, ec) : fs::symlink_status(path, ec);
+    e.type = st.type();
+    if (!ec && (fields & field::size) && e.type == fs::file_type::regular) {
+        e.size = fs::file_size(path, ec);
+    }
+    return e;
+}
+
+#endif // SCAN_POSIX
+
+} // namespace scan
+
+#endif // SCAN_H_
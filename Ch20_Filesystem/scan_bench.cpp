@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metadata.hpp"
+#include "parallel_walk.hpp"
+#include "scan.hpp"
+
+/**
+ * Times the different ways of summing up the regular files of a tree (e.g. one generated with
+ * gentree) - the best of several runs, so with a warm dentry and inode cache:
+ * - std::filesystem: recursive_directory_iterator, with is_regular_file(p) + file_size(p) per
+ *   entry, each a stat() of the full path (the way dirsize.cpp started out),
+ * - std::filesystem with the cached directory_entry::is_regular_file() / file_size(),
+ * - checkpath-style: scan::stat() of the full path of each entry, listed with scan::Directory,
+ * - parallel_dirsize() with 1 and with --threads workers, synchronous and with io_uring.
+ * All variants have to agree on the result, symlinks to files are counted like the files.
+ */
+
+namespace fs = std::filesystem;
+
+struct Result {
+    std::uint64_t files{0};
+    std::uint64_t bytes{0};
+};
+
+Result filesystem_paths(fs::path const& root)
+{
+    Result r;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator pos{root, ec}, end; !ec && pos != end;
+         pos.increment(ec)) {
+        auto const& p = pos->path();
+        if (is_regular_file(p, ec)) {
+            ++r.files;
+            r.bytes += file_size(p, ec);
+        }
+    }
+    return r;
+}
+
+Result filesystem_entries(fs::path const& root)
+{
+    Result r;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator pos{root, ec}, end; !ec && pos != end;
+         pos.increment(ec)) {
+        if (pos->is_regular_file(ec)) {
+            ++r.files;
+            r.bytes += pos->file_size(ec);
+        }
+    }
+    return r;
+}
+
+void stat_paths(fs::path const& dir, Result& r)
+{
+    std::error_code ec;
+    auto const d = scan::Directory::open(dir, ec);
+    if (!d) {
+        return;
+    }
+    d.for_each(0, [&](scan::Entry const& e) {
+        auto const path = dir / e.name;
+        auto const st = scan::stat(path, scan::field::size | scan::field::follow, ec);
+        if (st.type == fs::file_type::regular) {
+            ++r.files;
+            r.bytes += st.size;
+        }
+        else if (e.type == fs::file_type::directory) {
+            stat_paths(path, r);
+        }
+    });
+}
+
+Result checkpath_style(fs::path const& root)
+{
+    Result r;
+    stat_paths(root, r);
+    return r;
+}
+
+Result walker(fs::path const& root, std::size_t threads, scan::Backend backend)
+{
+    WalkOptions opts;
+    opts.threads = threads;
+    opts.backend = backend;
+    auto const sz = parallel_dirsize(root, opts);
+    return Result{sz.files, sz.bytes};
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace std::chrono;
+    std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+    int repeat{3};
+    char const* root_arg{nullptr};
+    for (int i{1}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(std::atoi(argv[++i]), 1);
+        }
+        else {
+            root_arg = argv[i];
+        }
+    }
+    if (!root_arg) {
+        std::cerr << "Usage: " << argv[0] << " [--threads <n>] [--repeat <n>] <path>\n";
+        return EXIT_FAILURE;
+    }
+    fs::path const root{root_arg};
+
+    auto const uring = scan::Metadata{scan::Backend::uring, 1}.async();
+    auto const n = std::to_string(threads);
+    struct Variant {
+        std::string name;
+        std::function<Result()> run;
+    };
+    std::vector<Variant> variants{
+        {"filesystem, stat per query", [&] { return filesystem_paths(root); }},
+        {"filesystem, cached entries", [&] { return filesystem_entries(root); }},
+        {"checkpath-style stat(path)", [&] { return checkpath_style(root); }},
+        {"walker, 1 thread", [&] { return walker(root, 1, scan::Backend::sync); }},
+        {"walker, " + n + " threads", [&] { return walker(root, threads, scan::Backend::sync); }},
+    };
+    if (uring) {
+        variants.push_back({"walker, io_uring, 1 thread",
+                            [&] { return walker(root, 1, scan::Backend::uring); }});
+        variants.push_back({"walker, io_uring, " + n + " threads",
+                            [&] { return walker(root, threads, scan::Backend::uring); }});
+    }
+
+    Result expected;
+    bool ok{true};
+    std::cout << std::fixed << std::setprecision(2);
+    for (auto const& v : variants) {
+        duration<double, std::milli> best{duration<double>::max()};
+        Result r;
+        for (int i{0}; i < repeat; ++i) {
+            auto const start = steady_clock::now();
+            r = v.run();
+            best = std::min(best, duration<double, std::milli>{steady_clock::now() - start});
+        }
+        if (&v == &variants.front()) {
+            expected = r;
+        }
+        bool const same = r.files == expected.files && r.bytes == expected.bytes;
+        ok = ok && same;
+        std::cout << std::left << std::setw(34) << v.name << std::right << std::setw(10)
+                  << best.count() << " ms  " << r.files << " files, " << r.bytes << " bytes"
+                  << (same ? "" : "  MISMATCH") << '\n';
+    }
+    if (!uring) {
+        std::cout << "(io_uring not available)\n";
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,133 @@
+#if !defined(VISITED_SET_H_)
+#define VISITED_SET_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <per_thread.hpp>
+#include "scan.hpp"
+
+/**
+ * Remembers which files (by device and inode) a traversal has already seen.
+ *
+ * Following directory symlinks may lead back into an ancestor - a cycle, endless without such a
+ * set - or into a part of the tree which is visited anyway; bind mounts do the same without any
+ * symlink. Hard links are several names for one inode. Keyed by (dev, ino), a traversal enters
+ * each directory once and counts each file once, whichever name it reaches it by first.
+ *
+ * The set is shared by all workers of a parallel walk, so it's split into shards selected by the
+ * hash, each an open addressing table (16 bytes per slot, no node per key) with its own mutex.
+ * An insert holds the lock of one shard for a probe or two, so the workers rarely meet.
+ */
+
+namespace fs = std::filesystem;
+
+class VisitedSet
+{
+public:
+    explicit VisitedSet(unsigned shard_bits = 6)
+        : shards_{std::make_unique<Shard[]>(std::size_t{1} << shard_bits)}, shift_{64 - shard_bits}
+    {
+    }
+
+    // Adds (dev, ino), returns false if it was already in the set.
+    bool insert(std::uint64_t dev, std::uint64_t ino)
+    {
+        auto const h = hash(dev, ino);
+        auto& shard = shards_[h >> shift_];
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        if (dev == 0 && ino == 0) {     // the marker of empty slots
+            return !std::exchange(shard.zero, true);
+        }
+        if ((shard.used + 1) * 2 > shard.slots.size()) {
+            grow(shard);
+        }
+        auto const mask = shard.slots.size() - 1;
+        for (auto i = h & mask;; i = (i + 1) & mask) {
+            auto& slot = shard.slots[i];
+            if (slot.dev == dev && slot.ino == ino) {
+                return false;
+            }
+            if (slot.dev == 0 && slot.ino == 0) {
+                slot = Key{dev, ino};
+                ++shard.used;
+                return true;
+            }
+        }
+    }
+
+private:
+    struct Key {
+        std::uint64_t dev;
+        std::uint64_t ino;
+    };
+
+    struct alignas(destructive_interference_size) Shard {
+        std::mutex mutex{};
+        std::vector<Key> slots{};   // a power of 2, at most half of them used
+        std::size_t used{0};
+        bool zero{false};           // holds (0, 0)
+    };
+
+    static std::uint64_t hash(std::uint64_t dev, std::uint64_t ino) noexcept
+    {
+        // inode numbers are often dense, mix all their bits into the high bits (the shard)
+        auto h = ino ^ (dev * 0x9e3779b97f4a7c15ull);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    }
+
+    static void grow(Shard& shard)
+    {
+        std::vector<Key> slots(std::max<std::size_t>(shard.slots.size() * 2, 16), Key{0, 0});
+        auto const mask = slots.size() - 1;
+        for (auto const& key : shard.slots) {
+            if (key.dev != 0 || key.ino != 0) {
+                auto i = hash(key.dev, key.ino) & mask;
+                while (slots[i].dev != 0 || slots[i].ino != 0) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = key;
+            }
+        }
+        shard.slots = std::move(slots);
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+    unsigned shift_;
+};
+
+// Calls f(entry) for each directory_entry of recursive_directory_iterator{root, options}, but
+// enters each directory only once and reports each file only once, by the (dev, ino) of its
+// target - so follow_directory_symlink is safe from cycles. std::filesystem doesn't expose inode
+// numbers, so this stats each entry once more; parallel_walk() gets them from readdir().
+template <typename F>
+void walk_unique(fs::path const& root, fs::directory_options options, F&& f, std::error_code& ec)
+{
+    VisitedSet visited;
+    unsigned const fields{scan::field::dev | scan::field::ino | scan::field::follow};
+    auto const top = scan::stat(root, fields, ec);
+    if (ec) {
+        return;
+    }
+    visited.insert(top.dev, top.ino);
+    for (fs::recursive_directory_iterator pos{root, options, ec}, end; !ec && pos != end;
+         pos.increment(ec)) {
+        std::error_code stat_ec;
+        auto const id = scan::stat(pos->path(), fields, stat_ec);
+        if (!stat_ec && id.ino != 0 && !visited.insert(id.dev, id.ino)) {
+            pos.disable_recursion_pending();
+            continue;
+        }
+        f(*pos);    // incl. dangling symlinks, which have no target to compare
+    }
+}
+
+#endif // VISITED_SET_H_
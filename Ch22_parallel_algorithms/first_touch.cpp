@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <execution>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "first_touch.hpp"
+#include "timer.h"
+
+/**
+ * Compares three ways of preparing the input of a parallel loop:
+ * - serial:     std::generate_n into a reserve()d std::vector - one thread takes every page fault
+ *               and (on NUMA systems) all the pages end up on that thread's memory node,
+ * - first-touch: FirstTouchBuffer - pages are faulted in and elements constructed by the thread
+ *               which later processes them,
+ * - prefault:   as first-touch, but the pages are faulted in by a separate pass, which shows how
+ *               much of the init cost is page faulting rather than element construction.
+ *
+ * Run with a large element count (e.g. 100000000) to see the effect.
+ */
+
+struct Data {
+    double value;
+    double sqrt;
+};
+
+int main(int argc, char* argv[])
+{
+    std::size_t const num_elements = [argc, argv]() -> std::size_t {
+        if (argc > 1) {
+            return std::strtoull(argv[1], nullptr, 10);
+        }
+        return 10'000'000;
+    }();
+    std::size_t const parts = [argc, argv]() -> std::size_t {
+        if (argc > 2) {
+            return std::strtoull(argv[2], nullptr, 10);
+        }
+        return default_parallelism();
+    }();
+    std::cout << num_elements << " elements, " << parts << " threads\n\n";
+
+    auto const gen = [](std::size_t i) noexcept {
+        return Data{static_cast<double>(i) * 3.14159265359, 0.0};
+    };
+    auto const op = [](auto& val) noexcept { val.sqrt = std::sqrt(val.value); };
+
+    {
+        Timer t;
+        std::vector<Data> coll;
+        coll.reserve(num_elements);
+        std::generate_n(std::back_inserter(coll), num_elements,
+                        [&gen, i{std::size_t{0}}]() mutable noexcept { return gen(i++); });
+        t.print_diff("serial init:             ");
+        std::for_each(std::execution::par, std::begin(coll), std::end(coll), op);
+        t.print_diff("  std::for_each(par):    ");
+        std::for_each(std::execution::par, std::begin(coll), std::end(coll), op);
+        t.print_diff("  std::for_each(par):    ");
+    }
+    std::cout << "\n";
+    {
+        Timer t;
+        FirstTouchBuffer<Data> coll{num_elements, gen, parts};
+        t.print_diff("first-touch init:        ");
+        std::for_each(std::execution::par, std::begin(coll), std::end(coll), op);
+        t.print_diff("  std::for_each(par):    ");
+        coll.for_each(op);
+        t.print_diff("  partitioned for_each:  ");
+    }
+    std::cout << "\n";
+    {
+        Timer t;
+        FirstTouchBuffer<Data> coll{num_elements, gen, parts, true};
+        t.print_diff("prefault + init:         ");
+        coll.prefault();
+        t.print_diff("  prefault (no faults):  ");
+        coll.for_each(op);
+        t.print_diff("  partitioned for_each:  ");
+    }
+}
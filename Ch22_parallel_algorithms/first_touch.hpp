@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <profiler.hpp>
+
+/**
+ * On most operating systems `new`/`malloc` of a large block only reserves address space - the
+ * physical pages are mapped lazily, by the thread which touches (writes) them first. On NUMA
+ * machines the page is also placed on the memory node of that thread ("first-touch" placement).
+ *
+ * Filling a `reserve`d std::vector with a serial std::generate_n therefore makes a single thread
+ * take every page fault, and places the whole buffer on that thread's node. A later parallel loop
+ * over the data then pays for remote memory accesses on top of the serial fill.
+ *
+ * `FirstTouchBuffer` instead leaves its storage untouched at allocation, and constructs the
+ * elements in parallel using a `StaticPartition` - the same contiguous split of [0, size) into
+ * `parts` chunks that `parallel_for` uses later. `parallel_for` runs chunk `i` on a thread pinned
+ * to the same CPU each time (on Linux), so as long as the compute loop uses the same partition,
+ * each chunk is processed on the node whose memory it faulted in.
+ */
+
+// Split [0, size) into `parts` contiguous chunks of (almost) equal size.
+struct StaticPartition {
+    std::size_t size{};
+    std::size_t parts{1};
+
+    constexpr std::size_t begin(std::size_t part) const noexcept
+    {
+        return size / parts * part + std::min(part, size % parts);
+    }
+
+    constexpr std::size_t end(std::size_t part) const noexcept { return begin(part + 1); }
+};
+
+inline std::size_t default_parallelism() noexcept
+{
+    // hardware_concurrency() is allowed to return 0 if the value is not computable
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+namespace detail {
+
+// The CPUs this process may run on, in ascending order - empty where threads can't be pinned.
+inline std::vector<std::size_t> const& allowed_cpus()
+{
+    static std::vector<std::size_t> const cpus = [] {
+        std::vector<std::size_t> list;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (std::size_t cpu{0}; cpu < std::size_t{CPU_SETSIZE}; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    list.push_back(cpu);
+                }
+            }
+        }
+#endif
+        return list;
+    }();
+    return cpus;
+}
+
+// Pins the calling thread to the CPU of chunk `part`. A failure only costs locality.
+inline void pin_to_part(std::vector<std::size_t> const& cpus, std::size_t part) noexcept
+{
+#if defined(__linux__)
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[part % cpus.size()], &set);
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void)cpus;
+    (void)part;
+#endif
+}
+
+} // namespace detail
+
+// Call f(part, begin, end) for each chunk of the partition, each on its own std::thread. The
+// thread of chunk `i` is pinned to the same CPU on every call, so the chunks which construct a
+// buffer and those which later compute on it run on the same CPUs - and NUMA nodes. The calling
+// thread only waits, and stays unpinned. If f throws, all chunks are still waited for, then the
+// exception of the first chunk which threw is rethrown.
+template <typename F>
+void parallel_for(StaticPartition const& partition, F&& f)
+{
+    auto const& cpus = detail::allowed_cpus();
+    std::vector<std::exception_ptr> errors(partition.parts);
+    std::vector<std::thread> workers;
+    workers.reserve(partition.parts);
+    auto const join_all = [&workers] {
+        for (auto& w : workers) {
+            w.join();
+        }
+    };
+    try {
+        for (std::size_t part{0}; part < partition.parts; ++part) {
+            workers.emplace_back([&f, &partition, &cpus, &errors, part] {
+                detail::pin_to_part(cpus, part);
+                try {
+                    ProfileZone zone{"parallel_for chunk"};
+                    f(part, partition.begin(part), partition.end(part));
+                }
+                catch (...) {
+                    errors[part] = std::current_exception();
+                }
+            });
+        }
+    }
+    catch (...) {
+        join_all();     // a thread couldn't be started - the others have to finish first
+        throw;
+    }
+    join_all();
+    for (auto const& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+template <typename T>
+class FirstTouchBuffer
+{
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = T const*;
+
+    static constexpr std::size_t page_size{4096};
+
+    // Allocates storage for `n` elements without touching it, optionally pre-faults the pages
+    // and then constructs element `i` from gen(i), each chunk on its own thread.
+    template <typename Gen>
+    FirstTouchBuffer(std::size_t n, Gen gen, std::size_t parts = default_parallelism(),
+                     bool prefault = false)
+        : partition_{n, std::max<std::size_t>(parts, 1)}, data_{allocate(n)}
+    {
+        if (prefault) {
+            this->prefault();
+        }
+        // if gen (or T's constructor) throws, the elements constructed so far are destroyed - a
+        // chunk cleans up after itself, the completed chunks are destroyed here
+        std::vector<char> done(partition_.parts, 0);
+        try {
+            parallel_for(partition_, [this, &gen, &done](std::size_t part, std::size_t first,
+                                                         std::size_t last) {
+                auto i{first};
+                try {
+                    for (; i != last; ++i) {
+                        ::new (static_cast<void*>(data_.get() + i)) T(gen(i));
+                    }
+                }
+                catch (...) {
+                    std::destroy(data_.get() + first, data_.get() + i);
+                    throw;
+                }
+                done[part] = 1;
+            });
+        }
+        catch (...) {
+            for (std::size_t part{0}; part < partition_.parts; ++part) {
+                if (done[part]) {
+                    std::destroy(data_.get() + partition_.begin(part),
+                                 data_.get() + partition_.end(part));
+                }
+            }
+            throw;
+        }
+    }
+
+    FirstTouchBuffer(FirstTouchBuffer const&) = delete;
+    FirstTouchBuffer& operator=(FirstTouchBuffer const&) = delete;
+    FirstTouchBuffer(FirstTouchBuffer&&) noexcept = default;
+
+    ~FirstTouchBuffer()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            if (data_) {
+                std::destroy_n(data_.get(), partition_.size);
+            }
+        }
+    }
+
+    // Write one byte per page of each chunk from the thread owning that chunk. This moves the
+    // page-fault cost out of element construction, e.g. to measure the two separately.
+    // The byte is written back unchanged (a read alone would only map the shared zero page),
+    // so this is also safe to call on constructed elements.
+    void prefault() noexcept
+    {
+        auto* const bytes = reinterpret_cast<unsigned char volatile*>(data_.get());
+        parallel_for(partition_, [bytes](std::size_t, std::size_t first, std::size_t last) {
+            auto const first_byte{first * sizeof(T)};
+            auto const last_byte{last * sizeof(T)};
+            for (auto b{first_byte}; b < last_byte; b += page_size) {
+                bytes[b] = bytes[b];
+            }
+        });
+    }
+
+    // Call f(element) for each element, partitioned the same way as construction.
+    template <typename F>
+    void for_each(F&& f)
+    {
+        parallel_for(partition_, [this, &f](std::size_t, std::size_t first, std::size_t last) {
+            std::for_each(data_.get() + first, data_.get() + last, f);
+        });
+    }
+
+    StaticPartition const& partition() const noexcept { return partition_; }
+
+    std::size_t size() const noexcept { return partition_.size; }
+    T* data() noexcept { return data_.get(); }
+    T const* data() const noexcept { return data_.get(); }
+    T& operator[](std::size_t i) noexcept { return data_[i]; }
+    T const& operator[](std::size_t i) const noexcept { return data_[i]; }
+
+    iterator begin() noexcept { return data_.get(); }
+    iterator end() noexcept { return data_.get() + size(); }
+    const_iterator begin() const noexcept { return data_.get(); }
+    const_iterator end() const noexcept { return data_.get() + size(); }
+
+private:
+    struct Deleter {
+        void operator()(T* p) const noexcept
+        {
+            ::operator delete(static_cast<void*>(p), std::align_val_t{page_size});
+        }
+    };
+
+    // page aligned, so that chunk boundaries and page boundaries line up as well as possible
+    static std::unique_ptr<T[], Deleter> allocate(std::size_t n)
+    {
+        auto* const raw = ::operator new(std::max<std::size_t>(n, 1) * sizeof(T),
+                                         std::align_val_t{page_size});
+        return std::unique_ptr<T[], Deleter>{static_cast<T*>(raw)};
+    }
+
+    StaticPartition partition_;
+    std::unique_ptr<T[], Deleter> data_;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
+#include "first_touch.hpp"
+
+/**
+ * Parallel scan, histogram and stable partition kernels built on `StaticPartition`/`parallel_for`.
+ *
+ * The std::execution::par versions of these algorithms have to work for any iterator category and
+ * any partitioning the backend chooses, so they frequently fail to beat the sequential versions.
+ * With a fixed, contiguous partition all three follow the same simple pattern:
+ *   1. each chunk computes a small summary (sum, count, per-bin count) of its own elements,
+ *   2. the (few) summaries are combined serially into per-chunk offsets,
+ *   3. each chunk writes its output, starting at its offset.
+ * Using the partition of the `FirstTouchBuffer` holding the input keeps every chunk on the thread
+ * that initialized it.
+ *
+ * Each kernel takes a projection `proj(element)`, so they can run directly over the `Data` records
+ * of measure.cpp without copying out the fields first.
+ */
+
+// out[i] = proj(in[0]) + ... + proj(in[i])
+template <typename T, typename Out, typename Proj>
+void partitioned_inclusive_scan(StaticPartition const& partition, T const* in, Out* out,
+                                Proj proj)
+{
+    std::vector<Out> chunk_sums(partition.parts, Out{});
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        Out sum{};
+        for (auto i{first}; i != last; ++i) {
+            sum += proj(in[i]);
+        }
+        chunk_sums[part] = sum;
+    });
+    std::exclusive_scan(chunk_sums.begin(), chunk_sums.end(), chunk_sums.begin(), Out{});
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        auto sum{chunk_sums[part]};
+        for (auto i{first}; i != last; ++i) {
+            sum += proj(in[i]);
+            out[i] = sum;
+        }
+    });
+}
+
+// out[i] = init + proj(in[0]) + ... + proj(in[i - 1])
+template <typename T, typename Out, typename Proj>
+void partitioned_exclusive_scan(StaticPartition const& partition, T const* in, Out* out,
+                                Out init, Proj proj)
+{
+    std::vector<Out> chunk_sums(partition.parts, Out{});
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        Out sum{};
+        for (auto i{first}; i != last; ++i) {
+            sum += proj(in[i]);
+        }
+        chunk_sums[part] = sum;
+    });
+    std::exclusive_scan(chunk_sums.begin(), chunk_sums.end(), chunk_sums.begin(), init);
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        auto sum{chunk_sums[part]};
+        for (auto i{first}; i != last; ++i) {
+            out[i] = sum;
+            sum += proj(in[i]);
+        }
+    });
+}
+
+// Counts of the elements per radix digit, `digit(element)` has to return a value in [0, Bins).
+// Each chunk counts into its own (stack) array, so there is no sharing between the threads.
+template <std::size_t Bins, typename T, typename Digit>
+std::array<std::size_t, Bins> partitioned_histogram(StaticPartition const& partition, T const* in,
+                                                    Digit digit)
+{
+    std::vector<std::array<std::size_t, Bins>> chunk_counts(partition.parts);
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        std::array<std::size_t, Bins> counts{};
+        for (auto i{first}; i != last; ++i) {
+            ++counts[digit(in[i])];
+        }
+        chunk_counts[part] = counts;
+    });
+    std::array<std::size_t, Bins> result{};
+    for (auto const& counts : chunk_counts) {
+        std::transform(result.begin(), result.end(), counts.begin(), result.begin(),
+                       std::plus<>{});
+    }
+    return result;
+}
+
+// Copies the elements satisfying `pred` to the front of `out` and the others behind them, keeping
+// the relative order in both groups (the out-of-place equivalent of std::stable_partition).
+// Returns the number of elements satisfying `pred`.
+template <typename T, typename Pred>
+std::size_t partitioned_stable_partition_copy(StaticPartition const& partition, T const* in,
+                                              T* out, Pred pred)
+{
+    std::vector<std::size_t> chunk_true(partition.parts, 0);
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        chunk_true[part] = static_cast<std::size_t>(std::count_if(in + first, in + last, pred));
+    });
+    auto const total_true = std::accumulate(chunk_true.cbegin(), chunk_true.cend(),
+                                            std::size_t{0});
+    std::vector<std::size_t> true_offsets(partition.parts);
+    std::exclusive_scan(chunk_true.cbegin(), chunk_true.cend(), true_offsets.begin(),
+                        std::size_t{0});
+    parallel_for(partition, [&](std::size_t part, std::size_t first, std::size_t last) {
+        // the false elements of all the preceding chunks come before ours
+        auto out_true{true_offsets[part]};
+        auto out_false{total_true + (first - true_offsets[part])};
+        for (auto i{first}; i != last; ++i) {
+            if (pred(in[i])) {
+                out[out_true++] = in[i];
+            }
+            else {
+                out[out_false++] = in[i];
+            }
+        }
+    });
+    return total_true;
+}
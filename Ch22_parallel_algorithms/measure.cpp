@@ -1,10 +1,15 @@
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <execution>
+#include <fstream>
 #include <iostream>
 #include <numeric>
+#include <utility>
 #include <vector>
 #include <iterator>
+#include "first_touch.hpp"
+#include "kernels.hpp"
 #include "timer.h"
 
 struct Data {
@@ -20,26 +25,154 @@ int main(int argc, char* argv[])
         }
         return 1000;
     }();
+    // optionally record a timeline of the runs, viewable in chrome://tracing or ui.perfetto.dev
+    char const* const trace_file{argc > 2 ? argv[2] : nullptr};
+    Profiler::instance().enable(trace_file != nullptr);
+    if (trace_file) {
+        Profiler::instance().set_thread_name("main");
+    }
+
+    // collect the timings and print them afterwards - writing to std::cout in between the runs
+    // would perturb the measurement
+    using Laps = std::vector<std::pair<char const*, double>>;
+    auto const print_laps = [](Laps const& laps) {
+        for (auto const& [name, ms] : laps) {
+            std::cout << name << ms << "ms\n";
+        }
+    };
 
-    std::vector<Data> coll;
-    coll.reserve(num_elements);
-    std::generate_n(std::back_inserter(coll), num_elements, [i{0}]() mutable noexcept {
-        return Data{i++ * 3.14159265359, 0.0};
-    });
+    // filling a reserve()d vector with std::generate_n would fault in every page on this thread,
+    // instead construct the elements in parallel, with the same partitioning as coll.for_each()
+    Timer init;
+    FirstTouchBuffer<Data> coll{static_cast<std::size_t>(num_elements),
+                                [](std::size_t i) noexcept {
+                                    return Data{static_cast<double>(i) * 3.14159265359, 0.0};
+                                }};
+    auto const init_ms{init.lap()};
+    std::cout << "parallel init: " << init_ms << "ms\n";
 
+    std::vector<std::array<double, 3>> rounds;
     for (auto i{0}; i < 5; ++i) {
+        ProfileZone round{"for_each round"};
         auto const op = [](auto& val) noexcept { val.sqrt = std::sqrt(val.value); };
         Timer t;
-        std::for_each(std::execution::seq,
-                      std::begin(coll), std::end(coll),
-                      op);
-        t.print_diff("sequential: ");
-
-        std::for_each(std::execution::par,
-                      std::begin(coll), std::end(coll),
-                      op);
-        t.print_diff("parallel: ");
-        std::cout << "\n";
+        {
+            ProfileZone zone{"for_each seq"};
+            std::for_each(std::execution::seq,
+                          std::begin(coll), std::end(coll),
+                          op);
+        }
+        auto const seq_ms{t.lap()};
+        {
+            ProfileZone zone{"for_each par"};
+            std::for_each(std::execution::par,
+                          std::begin(coll), std::end(coll),
+                          op);
+        }
+        auto const par_ms{t.lap()};
+        {
+            ProfileZone zone{"for_each partitioned"};
+            coll.for_each(op);
+        }
+        rounds.push_back({seq_ms, par_ms, t.lap()});
+    }
+    for (auto const& [seq_ms, par_ms, part_ms] : rounds) {
+        std::cout << "sequential: " << seq_ms << "ms\n"
+                  << "parallel: " << par_ms << "ms\n"
+                  << "partitioned: " << part_ms << "ms\n\n";
+    }
+
+    // --- scan, histogram and partition kernels
+    // each one is run as the sequential reference, with std::execution::par and as the
+    // partitioned kernel from kernels.hpp over the same partition as the input buffer.
+    auto const n{coll.size()};
+    auto const value = [](Data const& d) noexcept { return d.value; };
+    auto const max_rel_diff = [](std::vector<double> const& a, std::vector<double> const& b) {
+        double diff{0.0};
+        for (std::size_t i{0}; i < a.size(); ++i) {
+            if (a[i] != 0.0) {
+                diff = std::max(diff, std::abs((a[i] - b[i]) / a[i]));
+            }
+        }
+        return diff;
+    };
+    {
+        ProfileZone zone{"scan kernels"};
+        std::vector<double> ref(n);
+        std::vector<double> res(n);
+        Laps inclusive;
+        Laps exclusive;
+        Timer t;
+        std::transform_inclusive_scan(std::execution::seq, coll.begin(), coll.end(), ref.begin(),
+                                      std::plus<>{}, value);
+        inclusive.emplace_back("inclusive_scan sequential: ", t.lap());
+        std::transform_inclusive_scan(std::execution::par, coll.begin(), coll.end(), res.begin(),
+                                      std::plus<>{}, value);
+        inclusive.emplace_back("inclusive_scan parallel: ", t.lap());
+        partitioned_inclusive_scan(coll.partition(), coll.data(), res.data(), value);
+        inclusive.emplace_back("inclusive_scan partitioned: ", t.lap());
+        // floating point addition is not associative - results differ in the last bits
+        auto const inclusive_diff = max_rel_diff(ref, res);
+
+        t.lap();    // not the comparison
+        std::transform_exclusive_scan(std::execution::seq, coll.begin(), coll.end(), ref.begin(),
+                                      0.0, std::plus<>{}, value);
+        exclusive.emplace_back("exclusive_scan sequential: ", t.lap());
+        std::transform_exclusive_scan(std::execution::par, coll.begin(), coll.end(), res.begin(),
+                                      0.0, std::plus<>{}, value);
+        exclusive.emplace_back("exclusive_scan parallel: ", t.lap());
+        partitioned_exclusive_scan(coll.partition(), coll.data(), res.data(), 0.0, value);
+        exclusive.emplace_back("exclusive_scan partitioned: ", t.lap());
+        auto const exclusive_diff = max_rel_diff(ref, res);
+
+        print_laps(inclusive);
+        std::cout << "  max. relative difference: " << inclusive_diff << "\n";
+        print_laps(exclusive);
+        std::cout << "  max. relative difference: " << exclusive_diff << "\n\n";
+    }
+    {
+        ProfileZone zone{"histogram kernels"};
+        // radix digit: the lowest byte of the integral part of the value
+        constexpr std::size_t bins{256};
+        auto const digit = [](Data const& d) noexcept {
+            return static_cast<std::size_t>(d.value) % bins;
+        };
+        Laps laps;
+        Timer t;
+        std::array<std::size_t, bins> ref{};
+        std::for_each(coll.begin(), coll.end(), [&](Data const& d) { ++ref[digit(d)]; });
+        laps.emplace_back("histogram sequential: ", t.lap());
+        auto const res = partitioned_histogram<bins>(coll.partition(), coll.data(), digit);
+        laps.emplace_back("histogram partitioned: ", t.lap());
+        print_laps(laps);
+        std::cout << "  equal: " << std::boolalpha << (ref == res) << "\n\n";
+    }
+    {
+        ProfileZone zone{"partition kernels"};
+        auto const is_even = [](Data const& d) noexcept {
+            return static_cast<std::size_t>(d.value) % 2 == 0;
+        };
+        std::vector<Data> ref(coll.begin(), coll.end());
+        std::vector<Data> par(coll.begin(), coll.end());
+        std::vector<Data> res(n);
+        Laps laps;
+        Timer t;
+        std::stable_partition(std::execution::seq, ref.begin(), ref.end(), is_even);
+        laps.emplace_back("stable_partition sequential: ", t.lap());
+        std::stable_partition(std::execution::par, par.begin(), par.end(), is_even);
+        laps.emplace_back("stable_partition parallel: ", t.lap());
+        partitioned_stable_partition_copy(coll.partition(), coll.data(), res.data(), is_even);
+        laps.emplace_back("stable_partition partitioned: ", t.lap());
+        print_laps(laps);
+        auto const same = [](Data const& a, Data const& b) { return a.value == b.value; };
+        std::cout << "  equal: " << std::boolalpha
+                  << std::equal(ref.begin(), ref.end(), par.begin(), same) << " "
+                  << std::equal(ref.begin(), ref.end(), res.begin(), same) << "\n";
     }
 
+    if (trace_file) {
+        std::ofstream trace{trace_file};
+        Profiler::instance().write_chrome_trace(trace);
+        std::cout << "\ntrace written to " << trace_file << "\n";
+    }
 }
@@ -11,10 +11,18 @@ public:
     using clock_type = std::chrono::steady_clock;
 
     void print_diff(char const* const msg = "Timer diff: ") {
+        auto const diff{lap()};
+        std::cout << msg << diff << "ms\n";
+        last_ = clock_type::now();
+    }
+
+    // Milliseconds since construction or the previous lap() / print_diff(), without any output -
+    // to collect results during measurement and print them afterwards.
+    double lap() noexcept {
         auto const now{clock_type::now()};
         std::chrono::duration<double, std::milli> diff{now - last_};
-        std::cout << msg << diff.count() << "ms\n";
-        last_ = clock_type::now();
+        last_ = now;
+        return diff.count();
     }
 private:
     clock_type::time_point last_{clock_type::now()};
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <track_new.hpp>
+#include "string_interner.hpp"
+
+// Records which repeat the same keys, stored once as a std::string per record and once as the
+// ID of the key in a StringInterner (see string_interner.hpp) - then the same interner used by
+// several threads at once.
+
+std::vector<std::string> make_keys(std::size_t n)
+{
+    std::vector<std::string> keys;
+    for (std::size_t i{0}; i < n; ++i) {
+        keys.push_back("sensor.building-" + std::to_string(i % 7) + ".temperature.room-"
+                       + std::to_string(i));
+    }
+    return keys;
+}
+
+int main()
+{
+    using namespace std::chrono;
+    auto const keys = make_keys(1000);
+    constexpr std::size_t records{1'000'000};
+    std::mt19937 rng{1};
+
+    std::vector<std::size_t> picks(records);
+    for (auto& p : picks) {
+        p = rng() % keys.size();
+    }
+
+    // --- a std::string per record: the key is copied, and allocated for each one (not SSO)
+    {
+        TrackNew::reset();
+        auto const start = steady_clock::now();
+        std::vector<std::string> stored;
+        stored.reserve(records);
+        for (auto const p : picks) {
+            stored.push_back(keys[p]);
+        }
+        duration<double> const elapsed{steady_clock::now() - start};
+        std::cout << "std::string per record: " << elapsed.count() * 1000 << " ms, ";
+        TrackNew::status();
+    }
+
+    // --- the ID per record: each key is stored once, in the arena of the interner
+    {
+        TrackNew::reset();
+        // like in pmr2.cpp, the first block of the arena can be on the stack
+        std::array<std::byte, 64 * 1024> buf;
+        std::pmr::monotonic_buffer_resource pool{buf.data(), buf.size()};
+        StringInterner interner{&pool};
+        auto const start = steady_clock::now();
+        std::vector<StringInterner::id_type> stored;
+        stored.reserve(records);
+        for (auto const p : picks) {
+            stored.push_back(interner.intern(keys[p]));
+        }
+        duration<double> const elapsed{steady_clock::now() - start};
+        std::cout << "StringInterner ID per record: " << elapsed.count() * 1000 << " ms, "
+                  << interner.size() << " distinct keys, ";
+        TrackNew::status();
+        bool ok{true};
+        for (std::size_t i{0}; i < records; ++i) {
+            ok = ok && interner.str(stored[i]) == keys[picks[i]];
+        }
+        std::cout << (ok ? "all records read back\n" : "MISMATCH reading back\n");
+    }
+
+    // --- concurrently: writers intern the same keys in different orders, readers look them up
+    //     meanwhile - without a lock unless a key is new
+    StringInterner interner;
+    auto const many = make_keys(100'000);    // the hash table grows several times
+    std::vector<std::vector<StringInterner::id_type>> ids(4);
+    std::atomic<bool> writing{true};
+    std::atomic<std::size_t> wrong{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t{0}; t < ids.size(); ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<std::size_t> picked(many.size());
+            std::iota(picked.begin(), picked.end(), std::size_t{0});
+            std::shuffle(picked.begin(), picked.end(), std::mt19937{static_cast<unsigned>(t)});
+            ids[t].assign(many.size(), 0);
+            for (auto const p : picked) {
+                ids[t][p] = interner.intern(many[p]);
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        while (writing.load()) {
+            for (std::size_t i{0}; i < many.size(); i += 97) {
+                auto const id = interner.find(many[i]);
+                if (id && interner.str(*id) != many[i]) {
+                    ++wrong;
+                }
+            }
+        }
+    });
+    for (std::size_t t{0}; t < ids.size(); ++t) {
+        threads[t].join();
+    }
+    writing = false;
+    threads.back().join();
+    for (std::size_t i{0}; i < many.size(); ++i) {
+        auto const id = interner.find(many[i]);
+        for (auto const& v : ids) {
+            if (!id || v[i] != *id) {
+                ++wrong;
+            }
+        }
+        if (id && interner.str(*id) != many[i]) {
+            ++wrong;
+        }
+    }
+    std::cout << "4 writers and a reader: " << interner.size() << " distinct keys, " << wrong
+              << " inconsistencies\n";
+    return wrong == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
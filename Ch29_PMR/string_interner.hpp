@@ -0,0 +1,188 @@
+#if !defined(STRING_INTERNER_INCLUDE_HEADER_GUARD_)
+#define STRING_INTERNER_INCLUDE_HEADER_GUARD_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+// Stores each distinct string once, and hands out a 32 bit ID or a std::string_view for it - the
+// same one for equal strings. E.g. for records which repeat the same few keys millions of times: a
+// std::string per record would store (and copy, and compare) each key again and again.
+//
+// Everything is allocated from a std::pmr::monotonic_buffer_resource: the characters, one after
+// the other, and the tables of the IDs and of the hash table. Nothing is ever moved or freed until
+// the interner is destroyed - so the string_views stay valid as long as the interner lives.
+//
+// Lookups don't lock: find(), str() and intern() of a string which is already there only read
+// atomics. Adding a string takes a mutex. When the hash table grows, the new one is filled and
+// then published; the old one stays (in the arena) for readers which still probe it - a miss
+// there is checked again under the mutex (or retried by find()).
+class StringInterner
+{
+public:
+    using id_type = std::uint32_t;
+
+    explicit StringInterner(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : arena_{upstream}
+    {
+        table_.store(make_table(1024), std::memory_order_relaxed);
+    }
+
+    StringInterner(StringInterner const&) = delete;
+    StringInterner& operator=(StringInterner const&) = delete;
+
+    // The ID of `s`, added if it's new.
+    id_type intern(std::string_view s)
+    {
+        auto const hash = std::hash<std::string_view>{}(s);
+        if (auto const id = find(s, hash, table_.load(std::memory_order_acquire))) {
+            return *id;
+        }
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto* table = table_.load(std::memory_order_relaxed);
+        if (auto const id = find(s, hash, table)) {
+            return *id;     // added meanwhile
+        }
+        auto const id = static_cast<id_type>(size_.load(std::memory_order_relaxed));
+        if ((std::size_t{id} + 1) * 2 > table->mask + 1) {     // at most half full
+            table = grow(table);
+        }
+        auto* const chars = static_cast<char*>(arena_.allocate(s.size(), 1));
+        std::memcpy(chars, s.data(), s.size());
+        auto const [segment, offset] = locate(id);
+        auto* views = segments_[segment].load(std::memory_order_relaxed);
+        if (!views) {
+            auto const n = std::size_t{1} << (segment + base_bits);
+            views = static_cast<std::string_view*>(
+                arena_.allocate(n * sizeof(std::string_view), alignof(std::string_view)));
+            segments_[segment].store(views, std::memory_order_release);
+        }
+        new (views + offset) std::string_view{chars, s.size()};
+        // publishes the characters and the view with it
+        insert(table, hash, id);
+        size_.store(id + std::size_t{1}, std::memory_order_release);
+        return id;
+    }
+
+    // The interned copy of `s` - valid as long as the interner.
+    std::string_view intern_view(std::string_view s) { return str(intern(s)); }
+
+    // The ID of `s`, if it was interned.
+    std::optional<id_type> find(std::string_view s) const noexcept
+    {
+        auto const hash = std::hash<std::string_view>{}(s);
+        for (;;) {
+            auto const* const table = table_.load(std::memory_order_acquire);
+            if (auto const id = find(s, hash, table)) {
+                return id;
+            }
+            if (table == table_.load(std::memory_order_acquire)) {
+                return std::nullopt;    // not grown meanwhile, so it's not there
+            }
+        }
+    }
+
+    // The string of an ID from intern().
+    std::string_view str(id_type id) const noexcept
+    {
+        auto const [segment, offset] = locate(id);
+        return segments_[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    std::size_t size() const noexcept { return size_.load(std::memory_order_acquire); }
+
+private:
+    // The IDs, with the high bits of their hash, in open addressing with linear probing.
+    struct Table {
+        std::size_t mask;
+        std::atomic<std::uint64_t>* slots;      // 0: empty, else hash << 32 | (id + 1)
+    };
+
+    // The views of the IDs are in segments of 1024, 2048, 4096, ... - which never move.
+    static constexpr unsigned base_bits{10};
+
+    static std::pair<std::size_t, std::size_t> locate(id_type id) noexcept
+    {
+        auto const n = (std::uint64_t{id} >> base_bits) + 1;
+        std::size_t segment{0};
+        while (n >> (segment + 1)) {
+            ++segment;
+        }
+        return {segment, std::uint64_t{id} - (((std::uint64_t{1} << segment) - 1) << base_bits)};
+    }
+
+    static std::uint64_t tag(std::size_t hash) noexcept
+    {
+        return std::uint64_t{hash} >> 32 << 32;
+    }
+
+    std::optional<id_type> find(std::string_view s, std::size_t hash,
+                                Table const* table) const noexcept
+    {
+        for (auto i = hash & table->mask;; i = (i + 1) & table->mask) {
+            auto const slot = table->slots[i].load(std::memory_order_acquire);
+            if (slot == 0) {
+                return std::nullopt;
+            }
+            if ((slot & ~std::uint64_t{0xffffffff}) == tag(hash)) {
+                auto const id = static_cast<id_type>((slot & 0xffffffff) - 1);
+                if (str(id) == s) {
+                    return id;
+                }
+            }
+        }
+    }
+
+    static void insert(Table* table, std::size_t hash, id_type id) noexcept
+    {
+        auto i = hash & table->mask;
+        while (table->slots[i].load(std::memory_order_relaxed) != 0) {
+            i = (i + 1) & table->mask;
+        }
+        table->slots[i].store(tag(hash) | (std::uint64_t{id} + 1), std::memory_order_release);
+    }
+
+    Table* make_table(std::size_t size)
+    {
+        auto* const table =
+            new (arena_.allocate(sizeof(Table), alignof(Table))) Table{size - 1, nullptr};
+        auto* const slots = static_cast<std::atomic<std::uint64_t>*>(
+            arena_.allocate(sizeof(std::atomic<std::uint64_t>) * size,
+                            alignof(std::atomic<std::uint64_t>)));
+        for (std::size_t i{0}; i < size; ++i) {
+            new (slots + i) std::atomic<std::uint64_t>{0};
+        }
+        table->slots = slots;
+        return table;
+    }
+
+    // Twice the size, with the IDs rehashed - published only when it's complete.
+    Table* grow(Table const* old)
+    {
+        auto* const table = make_table((old->mask + 1) * 2);
+        auto const n = size_.load(std::memory_order_relaxed);
+        for (std::size_t id{0}; id < n; ++id) {
+            auto const i = static_cast<id_type>(id);
+            insert(table, std::hash<std::string_view>{}(str(i)), i);
+        }
+        table_.store(table, std::memory_order_release);
+        return table;
+    }
+
+    std::pmr::monotonic_buffer_resource arena_;     // only used under the mutex
+    std::mutex mutex_{};
+    std::atomic<Table*> table_{nullptr};
+    std::array<std::atomic<std::string_view*>, 32> segments_{};
+    std::atomic<std::size_t> size_{0};
+};
+
+#endif // STRING_INTERNER_INCLUDE_HEADER_GUARD_
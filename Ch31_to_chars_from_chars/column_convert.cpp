@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mapped_file.hpp>
+#include "column_store.hpp"
+
+/**
+ * Converts numeric columns between text (CSV) and the binary format of column_store.hpp, both
+ * ways with the input mapped (mapped_file), and reports sizes and times:
+ *
+ *     column_convert --to-binary [--types <types>] [--header] [--delta] <text file> <binary file>
+ *     column_convert --to-text <binary file> <text file>
+ *
+ * The text is parsed with csv::parse() (std::from_chars) and written with colstore::to_text()
+ * (std::to_chars, shortest form), so text from to_chars - like `csv_ingest --generate` - comes
+ * back byte for byte after a trip through the binary format. The types are one letter per
+ * column as for csv_ingest: i (64 bit integer), d (double) or s (skipped), "iidd" by default.
+ * --delta stores integer columns as varint differences.
+ */
+
+mapped_file map(char const* path)
+{
+    std::error_code ec;
+    mapped_file file{path, mapped_file::advice::willneed, ec};
+    if (ec || !file.is_mapped()) {
+        std::cerr << path << ": " << (ec ? ec.message() : "not a regular file") << '\n';
+        std::exit(EXIT_FAILURE);
+    }
+    return file;
+}
+
+void save(char const* path, textout::Buffer const& buffer)
+{
+    std::FILE* const file = std::fopen(path, "wb");
+    bool ok = file && std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    if (file) {
+        ok = std::fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        std::perror(path);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void report(char const* what, std::size_t in, std::size_t out,
+            std::chrono::duration<double> elapsed)
+{
+    std::cout << std::left << std::setw(12) << what << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << static_cast<double>(in) / 1e6
+              << " MB -> " << std::setw(10) << static_cast<double>(out) / 1e6 << " MB "
+              << std::setw(9) << elapsed.count() * 1000 << " ms\n";
+}
+
+int to_binary(char const* input, char const* output, std::vector<csv::Type> const& types,
+              csv::Options const& opts, colstore::Encoding ints)
+{
+    using namespace std::chrono;
+    auto const text = map(input);
+    auto start = steady_clock::now();
+    auto const table = csv::parse(text.view(), types, opts);
+    duration<double> const parsed{steady_clock::now() - start};
+    if (!table.errors.empty()) {
+        auto const& e = table.errors.front();
+        std::cerr << input << ": " << table.errors.size() << " errors, first in row " << e.row
+                  << ", column " << e.column << '\n';
+        return EXIT_FAILURE;
+    }
+    start = steady_clock::now();
+    textout::Buffer binary;
+    colstore::write(binary, table, ints);
+    duration<double> const written{steady_clock::now() - start};
+    save(output, binary);
+    std::cout << table.rows << " rows\n";
+    report("parse", text.view().size(), binary.size(), parsed);
+    report("encode", text.view().size(), binary.size(), written);
+
+    // what it takes to load the data again from either form
+    start = steady_clock::now();
+    csv::Table reloaded;
+    auto const ec = colstore::read(map(output).view(), reloaded);
+    duration<double> const loaded{steady_clock::now() - start};
+    report("reload", binary.size(), reloaded.rows * reloaded.columns.size() * 8, loaded);
+    return ec == std::errc{} ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int to_text(char const* input, char const* output)
+{
+    using namespace std::chrono;
+    auto const binary = map(input);
+    auto start = steady_clock::now();
+    csv::Table table;
+    if (colstore::read(binary.view(), table) != std::errc{}) {
+        std::cerr << input << ": not a column file, or damaged\n";
+        return EXIT_FAILURE;
+    }
+    duration<double> const loaded{steady_clock::now() - start};
+    start = steady_clock::now();
+    textout::Buffer text;
+    colstore::to_text(text, table, 0, table.rows);
+    duration<double> const formatted{steady_clock::now() - start};
+    save(output, text);
+    std::cout << table.rows << " rows\n";
+    report("decode", binary.view().size(), text.size(), loaded);
+    report("format", binary.view().size(), text.size(), formatted);
+    return EXIT_SUCCESS;
+}
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog
+              << " --to-binary [--types <i|d|s...>] [--header] [--delta] <text> <binary>\n"
+              << "       " << prog << " --to-text <binary> <text>\n";
+}
+
+int main(int argc, char* argv[])
+{
+    csv::Options opts;
+    std::string type_letters{"iidd"};
+    auto ints = colstore::Encoding::plain;
+    std::vector<char const*> paths;
+    for (int i{2}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--types") == 0 && i + 1 < argc) {
+            type_letters = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--header") == 0) {
+            opts.header = true;
+        }
+        else if (std::strcmp(argv[i], "--delta") == 0) {
+            ints = colstore::Encoding::delta_varint;
+        }
+        else {
+            paths.push_back(argv[i]);
+        }
+    }
+    std::vector<csv::Type> types;
+    for (auto const letter : type_letters) {
+        if (letter != 'i' && letter != 'd' && letter != 's') {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        types.push_back(letter == 'i' ? csv::Type::int64
+                        : letter == 'd' ? csv::Type::float64
+                                        : csv::Type::skip);
+    }
+    if (argc > 1 && paths.size() == 2) {
+        if (std::strcmp(argv[1], "--to-binary") == 0) {
+            return to_binary(paths[0], paths[1], types, opts, ints);
+        }
+        if (std::strcmp(argv[1], "--to-text") == 0) {
+            return to_text(paths[0], paths[1]);
+        }
+    }
+    usage(argv[0]);
+    return EXIT_FAILURE;
+}
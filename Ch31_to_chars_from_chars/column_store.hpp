@@ -0,0 +1,344 @@
+#ifndef COLUMN_STORE_HEADER_GUARD
+#define COLUMN_STORE_HEADER_GUARD
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "csv_columns.hpp"
+#include "double_writer.hpp"
+
+/**
+ * A compact binary file format for the columns of a csv::Table (see csv_columns.hpp), and the way
+ * back to text - the two forms of the same data: text to exchange and read, binary to store and
+ * reload. As text, a double takes up to 24 characters and has to be parsed again on every load;
+ * in binary it's 8 bytes, which are copied.
+ *
+ * The layout, all numbers little endian:
+ *
+ *     "CPP17COL"  u32 version (1)  u32 columns  u64 rows
+ *     per column: u8 type (1 int64, 2 float64)  u8 encoding  u16 name size  u32 0
+ *                 u64 offset of the data  u64 size of the data
+ *     the names, one after the other
+ *     the data of each column, at an offset which is a multiple of 8
+ *
+ * The data is either plain - 8 bytes per value, copied in one go on a little endian host - or,
+ * for integers, the difference to the previous value, zigzag encoded (small negative differences
+ * become small numbers) as a varint, 7 bits per byte. Sorted IDs and timestamps shrink to 1 to 4
+ * bytes per value that way.
+ *
+ * Skipped columns of a table aren't stored. read() checks the whole structure, so a truncated or
+ * foreign file is an error, not a crash.
+ */
+
+namespace colstore {
+
+enum class Encoding : std::uint8_t {
+    plain = 0,
+    delta_varint = 1,       // int64 columns only, doubles are always plain
+};
+
+namespace detail {
+
+inline constexpr char magic[8]{'C', 'P', 'P', '1', '7', 'C', 'O', 'L'};
+inline constexpr std::uint32_t version{1};
+inline constexpr std::size_t header_size{24};
+inline constexpr std::size_t descriptor_size{24};
+
+inline constexpr bool little_endian{
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#elif defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+    true
+#else
+    false
+#endif
+};
+
+template <typename T>
+char* put(char* p, T value) noexcept
+{
+    auto u = static_cast<std::uint64_t>(value);
+    for (std::size_t i{0}; i < sizeof(T); ++i, u >>= 8) {
+        *p++ = static_cast<char>(u & 0xff);
+    }
+    return p;
+}
+
+template <typename T>
+T get(char const* p) noexcept
+{
+    std::uint64_t u{0};
+    for (std::size_t i{sizeof(T)}; i-- != 0;) {
+        u = (u << 8) | static_cast<unsigned char>(p[i]);
+    }
+    return static_cast<T>(u);
+}
+
+// 8 byte values, as their bits.
+template <typename T>
+char* put_values(char* p, std::vector<T> const& values) noexcept
+{
+    static_assert(sizeof(T) == 8);
+    if constexpr (little_endian) {
+        std::memcpy(p, values.data(), values.size() * 8);
+        return p + values.size() * 8;
+    }
+    for (auto const v : values) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, 8);
+        p = put(p, bits);
+    }
+    return p;
+}
+
+template <typename T>
+void get_values(char const* p, std::vector<T>& values) noexcept
+{
+    static_assert(sizeof(T) == 8);
+    if constexpr (little_endian) {
+        std::memcpy(values.data(), p, values.size() * 8);
+        return;
+    }
+    for (auto& v : values) {
+        auto const bits = get<std::uint64_t>(p);
+        std::memcpy(&v, &bits, 8);
+        p += 8;
+    }
+}
+
+// At most 10 bytes per value.
+inline char* put_deltas(char* p, std::vector<std::int64_t> const& values) noexcept
+{
+    std::uint64_t previous{0};
+    for (auto const v : values) {
+        // wraps around instead of overflowing, and undone the same way
+        auto const delta = static_cast<std::uint64_t>(v) - previous;
+        previous = static_cast<std::uint64_t>(v);
+        auto zigzag = (delta << 1) ^ (delta >> 63 != 0 ? ~std::uint64_t{0} : 0);
+        for (; zigzag >= 0x80; zigzag >>= 7) {
+            *p++ = static_cast<char>((zigzag & 0x7f) | 0x80);
+        }
+        *p++ = static_cast<char>(zigzag);
+    }
+    return p;
+}
+
+inline bool get_deltas(char const* p, char const* last, std::vector<std::int64_t>& values) noexcept
+{
+    std::uint64_t previous{0};
+    for (auto& v : values) {
+        std::uint64_t zigzag{0};
+        for (unsigned shift{0};; shift += 7) {
+            if (p == last || shift > 63) {
+                return false;
+            }
+            auto const byte = static_cast<unsigned char>(*p++);
+            zigzag |= std::uint64_t{byte & 0x7fu} << shift;
+            if (byte < 0x80) {
+                break;
+            }
+        }
+        previous += (zigzag >> 1) ^ (zigzag & 1 ? ~std::uint64_t{0} : 0);
+        v = static_cast<std::int64_t>(previous);
+    }
+    return p == last;
+}
+
+inline std::size_t align8(std::size_t n) noexcept { return (n + 7) & ~std::size_t{7}; }
+
+} // namespace detail
+
+// Appends `table` in the binary format to `out`, integer columns with `ints`.
+inline void write(textout::Buffer& out, csv::Table const& table, Encoding ints = Encoding::plain)
+{
+    std::vector<std::size_t> stored;
+    for (std::size_t c{0}; c < table.columns.size(); ++c) {
+        if (table.columns[c].type != csv::Type::skip) {
+            stored.push_back(c);
+        }
+    }
+    auto const name = [&](std::size_t c) {
+        return table.names.size() == table.columns.size() ? std::string_view{table.names[c]}
+                                                          : std::string_view{};
+    };
+
+    // the upper bound of everything, so the data can be written straight into the buffer
+    auto size = detail::header_size + stored.size() * detail::descriptor_size;
+    for (auto const c : stored) {
+        size += name(c).size();
+    }
+    auto const names_end = size;
+    size = detail::align8(size) + stored.size() * (table.rows * 10 + 8);
+    auto* const first = out.prepare(size);
+
+    auto* p = first;
+    std::memcpy(p, detail::magic, sizeof(detail::magic));
+    p = detail::put(p + sizeof(detail::magic), detail::version);
+    p = detail::put(p, static_cast<std::uint32_t>(stored.size()));
+    p = detail::put(p, static_cast<std::uint64_t>(table.rows));
+    auto* descriptor = p;
+    p += stored.size() * detail::descriptor_size;
+    for (auto const c : stored) {
+        std::memcpy(p, name(c).data(), name(c).size());
+        p += name(c).size();
+    }
+    auto* data = first + detail::align8(names_end);
+    std::memset(p, 0, static_cast<std::size_t>(data - p));
+
+    for (auto const c : stored) {
+        auto const& column = table.columns[c];
+        bool const ints_column = column.type == csv::Type::int64;
+        auto const encoding = ints_column ? ints : Encoding::plain;
+        auto* end = data;
+        if (!ints_column) {
+            end = detail::put_values(data, column.doubles);
+        }
+        else if (encoding == Encoding::plain) {
+            end = detail::put_values(data, column.ints);
+        }
+        else {
+            end = detail::put_deltas(data, column.ints);
+        }
+        descriptor = detail::put(descriptor, static_cast<std::uint8_t>(ints_column ? 1 : 2));
+        descriptor = detail::put(descriptor, static_cast<std::uint8_t>(encoding));
+        descriptor = detail::put(descriptor, static_cast<std::uint16_t>(name(c).size()));
+        descriptor = detail::put(descriptor, std::uint32_t{0});
+        descriptor = detail::put(descriptor, static_cast<std::uint64_t>(data - first));
+        descriptor = detail::put(descriptor, static_cast<std::uint64_t>(end - data));
+        auto* const next = first + detail::align8(static_cast<std::size_t>(end - first));
+        std::memset(end, 0, static_cast<std::size_t>(next - end));
+        data = next;
+    }
+    out.commit(data);
+}
+
+// Reads a table in the binary format, e.g. the view() of a mapped_file. Returns
+// invalid_argument if `bytes` isn't a complete table.
+inline std::errc read(std::string_view bytes, csv::Table& table)
+{
+    auto const* const first = bytes.data();
+    auto const size = bytes.size();
+    if (size < detail::header_size
+        || std::memcmp(first, detail::magic, sizeof(detail::magic)) != 0
+        || detail::get<std::uint32_t>(first + 8) != detail::version) {
+        return std::errc::invalid_argument;
+    }
+    auto const columns = detail::get<std::uint32_t>(first + 12);
+    auto const rows = detail::get<std::uint64_t>(first + 16);
+    if (size < detail::header_size + std::size_t{columns} * detail::descriptor_size) {
+        return std::errc::invalid_argument;
+    }
+
+    csv::Table result;
+    result.rows = static_cast<std::size_t>(rows);
+    auto const* names = first + detail::header_size + columns * detail::descriptor_size;
+    bool named{false};
+    for (std::uint32_t c{0}; c < columns; ++c) {
+        auto const* const d = first + detail::header_size + c * detail::descriptor_size;
+        auto const type = detail::get<std::uint8_t>(d);
+        auto const encoding = detail::get<std::uint8_t>(d + 1);
+        auto const name_size = detail::get<std::uint16_t>(d + 2);
+        auto const offset = detail::get<std::uint64_t>(d + 8);
+        auto const data_size = detail::get<std::uint64_t>(d + 16);
+        bool const plain = encoding == static_cast<std::uint8_t>(Encoding::plain);
+        bool const deltas =
+            type == 1 && encoding == static_cast<std::uint8_t>(Encoding::delta_varint);
+        // a varint takes at least a byte, so a broken row count can't allocate the world
+        if ((type != 1 && type != 2) || (!plain && !deltas)
+            || static_cast<std::size_t>(names - first) + name_size > size || offset > size
+            || data_size > size - offset || (plain && data_size / 8 != rows)
+            || (deltas && data_size < rows)) {
+            return std::errc::invalid_argument;
+        }
+        result.names.emplace_back(names, name_size);
+        names += name_size;
+        named = named || name_size != 0;
+
+        auto& column = result.columns.emplace_back();
+        auto const* const data = first + offset;
+        if (type == 2) {
+            column.type = csv::Type::float64;
+            column.doubles.resize(result.rows);
+            detail::get_values(data, column.doubles);
+            continue;
+        }
+        column.type = csv::Type::int64;
+        column.ints.resize(result.rows);
+        if (plain) {
+            detail::get_values(data, column.ints);
+        }
+        else if (!detail::get_deltas(data, data + data_size, column.ints)) {
+            return std::errc::invalid_argument;
+        }
+    }
+    if (!named) {
+        result.names.clear();
+    }
+    table = std::move(result);
+    return std::errc{};
+}
+
+// Appends rows [first, last) of `table` as text, each value in the shortest form which reads back
+// the same, and the names as a header line if `first` is 0 and there are names.
+inline void to_text(textout::Buffer& out, csv::Table const& table, std::size_t first,
+                    std::size_t last, char delimiter = ',')
+{
+    std::vector<csv::Column const*> columns;
+    for (std::size_t c{0}; c < table.columns.size(); ++c) {
+        if (table.columns[c].type != csv::Type::skip) {
+            columns.push_back(&table.columns[c]);
+            if (first == 0 && table.names.size() == table.columns.size()) {
+                if (columns.size() > 1) {
+                    out.append({&delimiter, 1});
+                }
+                out.append(table.names[c]);
+            }
+        }
+    }
+    if (first == 0 && table.names.size() == table.columns.size() && !columns.empty()) {
+        out.append("\n");
+    }
+    if (columns.empty()) {
+        return;
+    }
+
+    constexpr std::size_t int_chars{20};    // "-9223372036854775808"
+    auto const row_chars = columns.size() * (textout::max_chars<double> + 1);
+    auto* p = out.prepare((last - first) * row_chars);
+    for (auto row = first; row < last; ++row) {
+        for (auto const* column : columns) {
+            p = column->type == csv::Type::int64
+                    ? std::to_chars(p, p + int_chars, column->ints[row]).ptr
+                    : std::to_chars(p, p + textout::max_chars<double>, column->doubles[row]).ptr;
+            *p++ = delimiter;
+        }
+        p[-1] = '\n';
+    }
+    out.commit(p);
+}
+
+// Writes `table` as text to `file`, in batches of `batch` rows. Returns false if writing failed.
+inline bool to_text(std::FILE* file, csv::Table const& table, char delimiter = ',',
+                    std::size_t batch = 64 * 1024)
+{
+    textout::Buffer out;
+    for (std::size_t first{0}; first == 0 || first < table.rows; first += batch) {
+        out.clear();
+        to_text(out, table, first, std::min(table.rows, first + batch), delimiter);
+        if (std::fwrite(out.data(), 1, out.size(), file) != out.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace colstore
+
+#endif // COLUMN_STORE_HEADER_GUARD
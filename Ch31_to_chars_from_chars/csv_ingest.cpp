@@ -0,0 +1,194 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <mapped_file.hpp>
+#include "csv_columns.hpp"
+
+/**
+ * Loads a numeric CSV file into columns with csv::parse() (see csv_columns.hpp), from a
+ * mapped_file, and compares it with extracting the same values with `>>` from an std::ifstream.
+ *
+ *     csv_ingest --generate <rows> <file>     writes a test file: id, timestamp, price, quantity
+ *     csv_ingest [--threads <n>] [--types <types>] [--header] <file>
+ *
+ * The types are one letter per column: i (64 bit integer), d (double) or s (skipped), "iidd" by
+ * default. The stream comparison only runs if no column is skipped.
+ */
+
+struct Sums {
+    std::int64_t ints{0};
+    double doubles{0.0};
+};
+
+bool operator==(Sums const& a, Sums const& b)
+{
+    return a.ints == b.ints && a.doubles == b.doubles;
+}
+
+void generate(std::size_t rows, char const* path)
+{
+    std::ofstream out{path};
+    std::mt19937_64 rng{42};
+    std::uniform_real_distribution<double> price{0.01, 10000.0};
+    std::lognormal_distribution<double> quantity{2.0, 1.5};
+    char line[128];
+    out << "id,timestamp,price,quantity\n";
+    for (std::size_t i{0}; i < rows; ++i) {
+        char* p = line;
+        p = std::to_chars(p, std::end(line), i).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, std::end(line), 1'700'000'000'000'000'000 + rng() % 1'000'000'000)
+                .ptr;
+        *p++ = ',';
+        p = std::to_chars(p, std::end(line), std::round(price(rng) * 100) / 100).ptr;
+        *p++ = ',';
+        p = std::to_chars(p, std::end(line), quantity(rng)).ptr;
+        *p++ = '\n';
+        out.write(line, p - line);
+    }
+}
+
+Sums sum(csv::Table const& table)
+{
+    Sums s;
+    for (auto const& column : table.columns) {
+        for (auto const v : column.ints) {
+            s.ints += v;
+        }
+        for (auto const v : column.doubles) {
+            s.doubles += v;
+        }
+    }
+    return s;
+}
+
+Sums with_stream(char const* path, std::vector<csv::Type> const& types, bool header)
+{
+    Sums s;
+    std::ifstream in{path};
+    std::string line;
+    if (header) {
+        std::getline(in, line);
+    }
+    std::int64_t i;
+    double d;
+    char delimiter;
+    // summed up column by column like sum(), so both add the doubles in the same order
+    std::vector<std::vector<std::int64_t>> ints(types.size());
+    std::vector<std::vector<double>> doubles(types.size());
+    while (in) {
+        for (std::size_t c{0}; c < types.size(); ++c) {
+            if (c != 0) {
+                in >> delimiter;
+            }
+            if (types[c] == csv::Type::int64 && in >> i) {
+                ints[c].push_back(i);
+            }
+            else if (types[c] == csv::Type::float64 && in >> d) {
+                doubles[c].push_back(d);
+            }
+        }
+    }
+    for (std::size_t c{0}; c < types.size(); ++c) {
+        for (auto const v : ints[c]) {
+            s.ints += v;
+        }
+        for (auto const v : doubles[c]) {
+            s.doubles += v;
+        }
+    }
+    return s;
+}
+
+void usage(char const* prog)
+{
+    std::cerr << "Usage: " << prog << " --generate <rows> <file>\n"
+              << "       " << prog << " [--threads <n>] [--types <i|d|s...>] [--header] <file>\n";
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace std::chrono;
+    csv::Options opts;
+    std::string type_letters{"iidd"};
+    char const* path{nullptr};
+    for (int i{1}; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--generate") == 0 && i + 2 < argc) {
+            generate(std::strtoull(argv[i + 1], nullptr, 10), argv[i + 2]);
+            return EXIT_SUCCESS;
+        }
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+        }
+        else if (std::strcmp(argv[i], "--types") == 0 && i + 1 < argc) {
+            type_letters = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--header") == 0) {
+            opts.header = true;
+        }
+        else {
+            path = argv[i];
+        }
+    }
+    std::vector<csv::Type> types;
+    bool skips{false};
+    for (auto const letter : type_letters) {
+        if (letter != 'i' && letter != 'd' && letter != 's') {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        types.push_back(letter == 'i' ? csv::Type::int64
+                        : letter == 'd' ? csv::Type::float64
+                                        : csv::Type::skip);
+        skips = skips || letter == 's';
+    }
+    if (!path) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ec;
+    mapped_file file{path, mapped_file::advice::willneed, ec};
+    if (ec) {
+        std::cerr << path << ": " << ec.message() << '\n';
+        return EXIT_FAILURE;
+    }
+    if (!file.is_mapped()) {
+        std::cerr << path << ": not a regular file\n";
+        return EXIT_FAILURE;
+    }
+    auto start = steady_clock::now();
+    auto const table = csv::parse(file.view(), types, opts);
+    duration<double> const parsed{steady_clock::now() - start};
+    auto const mb = static_cast<double>(file.view().size()) / 1e6;
+    std::cout << std::fixed << std::setprecision(1) << "csv::parse: " << table.rows << " rows, "
+              << table.errors.size() << " errors, " << parsed.count() * 1000 << " ms, "
+              << mb / parsed.count() << " MB/s\n";
+    for (std::size_t i{0}; i < std::min<std::size_t>(table.errors.size(), 10); ++i) {
+        auto const& e = table.errors[i];
+        std::cout << "  row " << e.row << ", column " << e.column << ": "
+                  << std::make_error_code(e.ec).message() << '\n';
+    }
+    if (skips) {
+        return EXIT_SUCCESS;
+    }
+
+    start = steady_clock::now();
+    auto const streamed = with_stream(path, types, opts.header);
+    duration<double> const extracted{steady_clock::now() - start};
+    std::cout << "ifstream >>: " << extracted.count() * 1000 << " ms, " << mb / extracted.count()
+              << " MB/s\n";
+    if (table.errors.empty() && !(sum(table) == streamed)) {
+        std::cerr << "results differ\n";
+        return EXIT_FAILURE;
+    }
+}
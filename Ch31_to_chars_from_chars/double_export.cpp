@@ -0,0 +1,142 @@
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "double_writer.hpp"
+
+/**
+ * Compares two ways to export doubles as text, so that they read back as the same values:
+ * - std::ostream << std::setprecision(17) - the classic way, always 17 significant digits,
+ * - textout::write() (see double_writer.hpp) - std::to_chars in the shortest form, in batches.
+ * Both outputs are parsed back with std::from_chars and compared bit by bit with the input.
+ *
+ *     double_export [--count <n>] [--output <file>]
+ *
+ * With --output the values are written to a file with textout::write(FILE*) as well.
+ */
+
+std::vector<double> values(std::size_t count)
+{
+    std::mt19937_64 rng{17};
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    std::lognormal_distribution<double> price{3.0, 2.0};
+    std::normal_distribution<double> measurement{0.0, 1e6};
+    std::vector<double> v(count);
+    for (auto& d : v) {
+        switch (rng() % 4) {
+        case 0: d = unit(rng); break;
+        case 1: d = std::round(price(rng) * 100) / 100; break;     // short: 19.99
+        case 2: d = measurement(rng); break;
+        default: {
+            // any finite bit pattern, also subnormals and extreme exponents
+            std::uint64_t bits;
+            do {
+                bits = rng();
+                std::memcpy(&d, &bits, sizeof(d));
+            } while (!std::isfinite(d));
+        }
+        }
+    }
+    return v;
+}
+
+// Reads `text` back and compares with `expected`, bit by bit.
+bool same(std::string_view text, std::vector<double> const& expected)
+{
+    auto const* p = text.data();
+    auto const* const last = text.data() + text.size();
+    for (auto const e : expected) {
+        double d;
+        auto const r = std::from_chars(p, last, d);
+        if (r.ec != std::errc{} || std::memcmp(&d, &e, sizeof(d)) != 0) {
+            return false;
+        }
+        p = r.ptr + 1;
+    }
+    return p == last;
+}
+
+template <typename F>
+void measure(char const* name, std::size_t count, F&& f)
+{
+    using namespace std::chrono;
+    duration<double> best{duration<double>::max()};
+    std::size_t bytes{0};
+    for (int i{0}; i < 3; ++i) {
+        auto const start = steady_clock::now();
+        bytes = f();
+        best = std::min<duration<double>>(best, steady_clock::now() - start);
+    }
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << best.count() * 1000 << " ms "
+              << std::setw(7) << static_cast<double>(count) / best.count() / 1e6
+              << " M values/s " << std::setw(11) << bytes << " bytes\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count{2'000'000};
+    char const* output{nullptr};
+    for (int i{1}; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--count") == 0) {
+            count = std::strtoull(argv[i + 1], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0) {
+            output = argv[i + 1];
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--count <n>] [--output <file>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    auto const input = values(count);
+
+    std::string streamed;
+    measure("ostream setprecision(17)", count, [&] {
+        std::ostringstream out;
+        out << std::setprecision(17);
+        for (auto const d : input) {
+            out << d << ',';
+        }
+        streamed = out.str();
+        return streamed.size();
+    });
+
+    textout::Buffer buffer;
+    measure("textout::write, shortest", count, [&] {
+        buffer.clear();     // the capacity stays, like for the next batch of an export
+        textout::write(buffer, input.data(), input.size(), ',');
+        return buffer.size();
+    });
+
+    if (output) {
+        measure("textout::write to file", count, [&] {
+            std::FILE* const file = std::fopen(output, "wb");
+            bool ok = file && textout::write(file, input.data(), input.size(), '\n');
+            auto const written = ok ? std::ftell(file) : 0;
+            if (file) {
+                ok = std::fclose(file) == 0 && ok;
+            }
+            if (!ok) {
+                std::perror(output);
+                std::exit(EXIT_FAILURE);
+            }
+            return static_cast<std::size_t>(written);
+        });
+    }
+
+    bool const ok = same(streamed, input) && same(buffer.view(), input);
+    std::cout << (ok ? "both read back exactly\n" : "MISMATCH reading back\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,110 @@
+#ifndef DOUBLE_WRITER_HEADER_GUARD
+#define DOUBLE_WRITER_HEADER_GUARD
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Writes many floating-point values as text: each with std::to_chars() in its shortest form which
+ * still reads back as the same value (unlike a fixed precision, which either loses bits or
+ * prints noise digits), one after the other into a single growing buffer.
+ *
+ * d2str2d() in to_from_chars.hpp shows the conversion of one value, with a buffer on the stack
+ * and streams around it. For millions of values, everything besides to_chars has to go: the
+ * buffer grows geometrically (without initializing the new space, unlike std::string::resize),
+ * room for a whole batch is reserved once, and the values are written straight into it.
+ */
+
+namespace textout {
+
+class Buffer
+{
+public:
+    Buffer() = default;
+    explicit Buffer(std::size_t capacity) { reserve(capacity); }
+
+    char const* data() const noexcept { return data_.get(); }
+    std::size_t size() const noexcept { return size_; }
+    std::string_view view() const noexcept { return {data_.get(), size_}; }
+    void clear() noexcept { size_ = 0; }
+
+    // Makes room for at least `n` more characters, returns where they go. commit() says how many
+    // were used.
+    char* prepare(std::size_t n)
+    {
+        if (capacity_ - size_ < n) {
+            reserve(std::max(capacity_ * 2, size_ + n));
+        }
+        return data_.get() + size_;
+    }
+
+    void commit(char const* end) noexcept { size_ = static_cast<std::size_t>(end - data_.get()); }
+
+    void append(std::string_view s)
+    {
+        auto* const p = prepare(s.size());
+        std::memcpy(p, s.data(), s.size());
+        size_ += s.size();
+    }
+
+private:
+    void reserve(std::size_t capacity)
+    {
+        std::unique_ptr<char[]> grown{new char[capacity]};     // not zeroed, unlike make_unique
+        if (size_ != 0) {
+            std::memcpy(grown.get(), data_.get(), size_);
+        }
+        data_ = std::move(grown);
+        capacity_ = capacity;
+    }
+
+    std::unique_ptr<char[]> data_{};
+    std::size_t size_{0};
+    std::size_t capacity_{0};
+};
+
+// Longest shortest form: "-2.2250738585072014e-308" for double, "-1.17549435e-38" for float.
+template <typename T>
+inline constexpr std::size_t max_chars{sizeof(T) == sizeof(float) ? 15 : 24};
+
+// Appends `values`, each followed by `delimiter`.
+template <typename T>
+void write(Buffer& out, T const* values, std::size_t n, char delimiter)
+{
+    // max_chars is only known for these - a long double could be longer
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                  "textout::write: float or double only");
+    auto* p = out.prepare(n * (max_chars<T> + 1));
+    for (std::size_t i{0}; i < n; ++i) {
+        p = std::to_chars(p, p + max_chars<T>, values[i]).ptr;
+        *p++ = delimiter;
+    }
+    out.commit(p);
+}
+
+// Writes `values` to `file`, formatted in batches into one buffer, which is written with one
+// fwrite() per batch. Returns false if writing failed.
+template <typename T>
+bool write(std::FILE* file, T const* values, std::size_t n, char delimiter,
+           std::size_t batch = 64 * 1024)
+{
+    Buffer out{batch * (max_chars<T> + 1)};
+    for (std::size_t first{0}; first < n; first += batch) {
+        out.clear();
+        write(out, values + first, std::min(batch, n - first), delimiter);
+        if (std::fwrite(out.data(), 1, out.size(), file) != out.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace textout
+
+#endif // DOUBLE_WRITER_HEADER_GUARD
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Proves the round trip of d2str2d() (see to_from_chars.hpp) on a large scale: for every float -
+ * all 2^32 bit patterns - and for ranges of doubles, the text from std::to_chars has to read back
+ * with std::from_chars as exactly the same bits (NaNs as NaNs of the same sign).
+ *
+ * Every k-th value is also checked against the C library as a reference:
+ * - strtod()/strtof() have to read the text of to_chars as the same value,
+ * - the text has to be as short as the shortest "%.*e" which reads back - the number of
+ *   significant digits may be lower (printf only rounds to nearest, which can miss a shorter
+ *   representation right at a power of 2), but never higher. Integral values in plain form
+ *   ("908827436085075771392") are exact, so there the scientific form is checked, and that the
+ *   plain form isn't longer.
+ *
+ * The values are split into shards of 2^20, which the threads take from a shared counter.
+ *
+ *     roundtrip_verify [--threads <n>] [--floats <first>,<count>|none]
+ *                      [--random-doubles <count>] [--strided-doubles <first>,<stride>,<count>]
+ *                      [--reference-every <k>] [--seed <n>]
+ *
+ * The float range is given in bit patterns (default all of them: 0,4294967296), as are the first
+ * double and the stride; numbers may be hex (0x...).
+ */
+
+struct Options {
+    std::size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+    std::uint64_t reference_every{16};
+    std::uint64_t seed{1};
+};
+
+struct Result {
+    std::uint64_t values{0};
+    std::uint64_t referenced{0};
+    std::uint64_t round_trip_failures{0};
+    std::uint64_t reference_failures{0};    // strtod disagrees, or not shortest
+};
+
+template <typename T>
+using Bits = std::conditional_t<std::is_same_v<T, float>, std::uint32_t, std::uint64_t>;
+
+template <typename T>
+T from_bits(Bits<T> bits)
+{
+    T v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+template <typename T>
+bool identical(T a, T b)
+{
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b) && std::signbit(a) == std::signbit(b);
+    }
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// Significant digits of a finite number as written by to_chars, e.g. 3 for "-0.00123" or "123000".
+int significant_digits(char const* first, char const* last)
+{
+    std::string digits;
+    for (auto const* p = first; p != last && *p != 'e'; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            digits += *p;
+        }
+    }
+    auto const begin = digits.find_first_not_of('0');
+    if (begin == digits.npos) {
+        return 1;
+    }
+    return static_cast<int>(digits.find_last_not_of('0') - begin + 1);
+}
+
+template <typename T>
+T c_parse(char const* s)
+{
+    if constexpr (std::is_same_v<T, float>) {
+        return std::strtof(s, nullptr);
+    }
+    else {
+        return std::strtod(s, nullptr);
+    }
+}
+
+// The fewest significant digits with which printf's rounding reads back as `v`.
+template <typename T>
+int reference_digits(T v)
+{
+    constexpr int max_digits{std::numeric_limits<T>::max_digits10};
+    char text[64];
+    for (int digits{1}; digits < max_digits; ++digits) {
+        std::snprintf(text, sizeof(text), "%.*e", digits - 1, static_cast<double>(v));
+        if (identical(c_parse<T>(text), v)) {
+            return digits;
+        }
+    }
+    return max_digits;
+}
+
+std::string hex(std::uint64_t bits)
+{
+    char text[17];
+    return std::string(text, std::to_chars(text, text + sizeof(text), bits, 16).ptr);
+}
+
+// The first few failures, for the report.
+class Failures
+{
+public:
+    void add(std::string what)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (examples_.size() < 10) {
+            examples_.push_back(std::move(what));
+        }
+    }
+
+    void print() const
+    {
+        for (auto const& e : examples_) {
+            std::cout << "  " << e << '\n';
+        }
+    }
+
+private:
+    std::mutex mutex_{};
+    std::vector<std::string> examples_{};
+};
+
+// Checks the values bits_at(0), ..., bits_at(count - 1).
+template <typename T, typename BitsAt>
+Result verify(std::uint64_t count, BitsAt bits_at, Options const& opts, Failures& failures)
+{
+    constexpr std::uint64_t shard{1 << 20};
+    std::atomic<std::uint64_t> next{0};
+    std::vector<Result> results(opts.threads);
+
+    auto const worker = [&](std::size_t t) {
+        Result r;
+        char text[64];
+        for (auto first = next.fetch_add(shard); first < count; first = next.fetch_add(shard)) {
+            auto const last = std::min(count, first + shard);
+            for (auto i = first; i < last; ++i) {
+                auto const bits = bits_at(i);
+                auto const v = from_bits<T>(bits);
+                auto const end = std::to_chars(text, text + sizeof(text) - 1, v).ptr;
+                T back{};
+                auto const parsed = std::from_chars(text, end, back);
+                ++r.values;
+                if (parsed.ec != std::errc{} || parsed.ptr != end || !identical(back, v)) {
+                    ++r.round_trip_failures;
+                    failures.add("round trip 0x" + hex(bits) + " -> " + std::string(text, end));
+                    continue;
+                }
+                if (i % opts.reference_every != 0 || !std::isfinite(v)) {
+                    continue;
+                }
+                ++r.referenced;
+                *end = '\0';
+                auto digits = significant_digits(text, end);
+                bool shorter{true};
+                if (std::find_if(text, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+                    // integral values are written with all their digits (exact, not noise)
+                    // unless the scientific form is shorter - whose digits have to be shortest
+                    char sci[64];
+                    auto const sci_end = std::to_chars(sci, sci + sizeof(sci), v,
+                                                       std::chars_format::scientific).ptr;
+                    shorter = end - text <= sci_end - sci;
+                    digits = significant_digits(sci, sci_end);
+                }
+                if (!identical(c_parse<T>(text), v) || !shorter || digits > reference_digits(v)) {
+                    ++r.reference_failures;
+                    failures.add("reference 0x" + hex(bits) + " -> " + std::string(text, end));
+                }
+            }
+        }
+        results[t] = r;
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t t{1}; t < opts.threads; ++t) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    Result total;
+    for (auto const& r : results) {
+        total.values += r.values;
+        total.referenced += r.referenced;
+        total.round_trip_failures += r.round_trip_failures;
+        total.reference_failures += r.reference_failures;
+    }
+    return total;
+}
+
+template <typename T, typename BitsAt>
+bool run(char const* name, std::uint64_t count, BitsAt bits_at, Options const& opts)
+{
+    using namespace std::chrono;
+    Failures failures;
+    auto const start = steady_clock::now();
+    auto const r = verify<T>(count, bits_at, opts, failures);
+    duration<double> const elapsed{steady_clock::now() - start};
+    std::cout << name << ": " << r.values << " values in " << elapsed.count() << " s ("
+              << static_cast<double>(r.values) / elapsed.count() / 1e6 << " M/s), "
+              << r.round_trip_failures << " round trip failures, " << r.reference_failures
+              << " of " << r.referenced << " differ from the reference\n";
+    failures.print();
+    return r.round_trip_failures == 0 && r.reference_failures == 0;
+}
+
+std::uint64_t splitmix64(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Parses "a,b,c" (decimal or 0x hex) into `values`, returns false if the count doesn't match.
+bool numbers(char const* arg, std::vector<std::uint64_t>& values, std::size_t n)
+{
+    values.clear();
+    for (char* end{nullptr};; arg = end + 1) {
+        values.push_back(std::strtoull(arg, &end, 0));
+        if (end == arg || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        if (*end == '\0') {
+            break;
+        }
+    }
+    return values.size() == n;
+}
+
+int main(int argc, char* argv[])
+{
+    Options opts;
+    std::uint64_t float_first{0};
+    std::uint64_t float_count{std::uint64_t{1} << 32};
+    std::uint64_t random_doubles{0};
+    std::vector<std::uint64_t> strided;
+    std::vector<std::uint64_t> values;
+    for (int i{1}; i < argc; ++i) {
+        bool ok{i + 1 < argc};
+        char const* const arg = ok ? argv[i + 1] : "";
+        if (ok && std::strcmp(argv[i], "--threads") == 0) {
+            opts.threads = std::max<std::size_t>(std::strtoull(arg, nullptr, 0), 1);
+        }
+        else if (ok && std::strcmp(argv[i], "--floats") == 0) {
+            if (std::strcmp(arg, "none") == 0) {
+                float_count = 0;
+            }
+            // a range of the 2^32 bit patterns - the count is clamped to the last one
+            else if ((ok = numbers(arg, values, 2) && values[0] <= std::uint64_t{1} << 32)) {
+                float_first = values[0];
+                float_count = std::min(values[1], (std::uint64_t{1} << 32) - float_first);
+            }
+        }
+        else if (ok && std::strcmp(argv[i], "--random-doubles") == 0) {
+            random_doubles = std::strtoull(arg, nullptr, 0);
+        }
+        else if (ok && std::strcmp(argv[i], "--strided-doubles") == 0) {
+            ok = numbers(arg, strided, 3);
+        }
+        else if (ok && std::strcmp(argv[i], "--reference-every") == 0) {
+            opts.reference_every = std::max<std::uint64_t>(std::strtoull(arg, nullptr, 0), 1);
+        }
+        else if (ok && std::strcmp(argv[i], "--seed") == 0) {
+            opts.seed = std::strtoull(arg, nullptr, 0);
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--threads <n>] [--floats <first>,<count>|none]"
+                         " [--random-doubles <count>]\n"
+                         "       [--strided-doubles <first>,<stride>,<count>]"
+                         " [--reference-every <k>] [--seed <n>]\n";
+            return EXIT_FAILURE;
+        }
+        ++i;
+    }
+
+    bool ok{true};
+    if (float_count != 0) {
+        ok = run<float>("floats", float_count, [&](std::uint64_t i) {
+            return static_cast<std::uint32_t>(float_first + i);
+        }, opts) && ok;
+    }
+    if (random_doubles != 0) {
+        ok = run<double>("random doubles", random_doubles, [&](std::uint64_t i) {
+            return splitmix64(opts.seed + i);
+        }, opts) && ok;
+    }
+    if (!strided.empty()) {
+        ok = run<double>("strided doubles", strided[2], [&](std::uint64_t i) {
+            return strided[0] + i * strided[1];
+        }, opts) && ok;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <per_thread.hpp>
+
+/**
+ * `inline thread_local` variables (see inline_thread_local.hpp) give every thread its own object,
+ * but only that thread can reach it - a `thread_local` counter can't be summed up by a reporting
+ * thread. Putting the per-thread counters into an array makes them reachable, but neighbouring
+ * counters then share a cache line, and every increment invalidates the line in the caches of
+ * all the other threads ("false sharing").
+ *
+ * This measures the same per-thread increments with:
+ * - shared:  a single std::atomic, incremented by all threads (true sharing, for reference),
+ * - packed:  one std::atomic per thread, next to each other in an array (false sharing),
+ * - padded:  per_thread_counter - one std::atomic per thread, each in its own cache line.
+ * If `packed` is much slower than `padded`, the packed layout suffers from false sharing.
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename F>
+double run_threads(std::size_t num_threads, F const& f)
+{
+    auto const start{clock_type::now()};
+    std::vector<std::thread> threads;
+    for (std::size_t t{0}; t < num_threads; ++t) {
+        threads.emplace_back(f, t);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    return std::chrono::duration<double, std::milli>{clock_type::now() - start}.count();
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t const num_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                             : std::max(std::thread::hardware_concurrency(), 2u);
+    std::uint64_t const iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10'000'000;
+    std::cout << num_threads << " threads, " << iterations << " increments each\n";
+
+    std::atomic<std::uint64_t> shared{0};
+    auto const shared_ms = run_threads(num_threads, [&](std::size_t) {
+        for (std::uint64_t i{0}; i < iterations; ++i) {
+            shared.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    std::cout << "shared: " << shared_ms << "ms, total " << shared.load() << "\n";
+
+    // the same single-writer increment as add(per_thread_counter&), but without the padding
+    std::vector<std::atomic<std::uint64_t>> packed(num_threads);
+    auto const packed_ms = run_threads(num_threads, [&](std::size_t t) {
+        auto& slot = packed[t];
+        for (std::uint64_t i{0}; i < iterations; ++i) {
+            slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    });
+    std::uint64_t packed_total{0};
+    for (auto const& c : packed) {
+        packed_total += c.load();
+    }
+    std::cout << "packed: " << packed_ms << "ms, total " << packed_total << "\n";
+
+    per_thread_counter<std::uint64_t> padded{num_threads + 1};
+    auto const padded_ms = run_threads(num_threads, [&](std::size_t) {
+        // look up the slot once - local() has to go through the thread_local index
+        auto& slot = padded.local();
+        for (std::uint64_t i{0}; i < iterations; ++i) {
+            slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    });
+    std::cout << "padded: " << padded_ms << "ms, total " << sum(padded) << "\n";
+
+    auto const ratio = packed_ms / padded_ms;
+    std::cout << "packed / padded: " << ratio << "\n";
+    if (ratio > 1.5) {
+        std::cout << "false sharing detected between adjacent "
+                  << sizeof(std::atomic<std::uint64_t>) << " byte counters\n";
+    }
+}
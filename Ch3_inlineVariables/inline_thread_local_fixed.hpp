@@ -0,0 +1,96 @@
+#if !defined(INLINE_THREAD_LOCAL_FIXED_H_)
+#define INLINE_THREAD_LOCAL_FIXED_H_
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+/**
+ * A `thread_local` variable of a type with a non-trivial constructor or destructor (like
+ * std::string) is initialized dynamically: every thread which touches it runs the constructors,
+ * registers the destructors to be called at thread exit, and allocates if a string doesn't fit
+ * the small string buffer.
+ *
+ * If the type has a constexpr constructor and a trivial destructor, the initial value is stored
+ * in the TLS image of the program and copied by the OS/loader when a thread starts - there is no
+ * code to run at all, and no guard to check on access.
+ */
+
+// A string with inline storage for up to N characters. Longer values are truncated.
+template <std::size_t N>
+class FixedString
+{
+public:
+    constexpr FixedString() noexcept = default;
+
+    template <std::size_t M>
+    constexpr FixedString(char const (&str)[M]) noexcept    // NOLINT: implicit, like std::string
+    {
+        static_assert(M - 1 <= N, "string literal doesn't fit the FixedString");
+        for (std::size_t i{0}; i < M - 1; ++i) {
+            data_[i] = str[i];
+        }
+        size_ = M - 1;
+    }
+
+    FixedString& operator=(std::string_view sv) noexcept
+    {
+        size_ = std::min(sv.size(), N);
+        std::copy_n(sv.data(), size_, data_);
+        return *this;
+    }
+
+    constexpr std::string_view view() const noexcept { return {data_, size_}; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    static constexpr std::size_t capacity() noexcept { return N; }
+
+    friend std::ostream& operator<<(std::ostream& os, FixedString const& s)
+    {
+        return os << s.view();
+    }
+
+private:
+    char data_[N]{};
+    std::size_t size_{0};
+};
+
+struct MyDataFixed {
+    inline static FixedString<31> gName{"global"};              // unique per-program
+    inline static thread_local FixedString<31> tName{"tls"};    // unique per-thread
+    FixedString<31> lName{"local"};                             // for each object
+
+    void print(std::string_view msg) const {
+        std::cout << msg << "\n";
+        std::cout << "- gName: " << gName << "\n";
+        std::cout << "- tName: " << tName << "\n";
+        std::cout << "- lName: " << lName << "\n";
+    }
+};
+
+// constant-initialized - no dynamic TLS init, no thread-exit destructor, no heap allocation
+inline thread_local MyDataFixed myThreadDataFixed;    // one object per thread
+
+// Per-thread data which can't be constant-initialized (here: a name derived from the thread id) is
+// only computed the first time a thread asks for it. Threads which never call myThreadDataLazy()
+// - e.g. short-lived pool workers - pay nothing for it.
+inline MyDataFixed& myThreadDataLazy()
+{
+    static thread_local MyDataFixed data;               // constant-initialized
+    static thread_local bool initialized{false};
+    if (!initialized) {
+        // std::hash of the id is the only portable way to get a number out of std::thread::id
+        auto const id = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        char buf[FixedString<31>::capacity()];
+        constexpr std::string_view prefix{"thread-"};
+        std::copy(prefix.begin(), prefix.end(), buf);
+        auto const res = std::to_chars(buf + prefix.size(), buf + sizeof(buf), id);
+        data.lName = std::string_view{buf, static_cast<std::size_t>(res.ptr - buf)};
+        initialized = true;
+    }
+    return data;
+}
+
+#endif // INLINE_THREAD_LOCAL_FIXED_H_
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include "inline_thread_local.hpp"
+#include "inline_thread_local_fixed.hpp"
+
+/**
+ * Measures the latency from spawning a thread until it has written its thread_local data for the
+ * first time, for:
+ * - none:   no thread_local access at all (thread creation cost only),
+ * - string: MyData - dynamic TLS init of std::string members, heap allocation for the name,
+ * - fixed:  MyDataFixed - constant-initialized, inline storage,
+ * - lazy:   myThreadDataLazy() - as fixed, plus computing a per-thread name on first use.
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+// long enough to not fit into the small string buffer of std::string
+constexpr std::string_view worker_name{"bursty pool worker thread"};
+
+template <typename F>
+double spawn_to_first_use(int iterations, F const& first_use)
+{
+    std::chrono::duration<double, std::micro> total{};
+    for (auto i{0}; i < iterations; ++i) {
+        clock_type::time_point used;
+        auto const spawned{clock_type::now()};
+        std::thread t{[&used, &first_use] {
+            first_use();
+            used = clock_type::now();
+        }};
+        t.join();
+        total += used - spawned;
+    }
+    return total.count() / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    int const iterations = argc > 1 ? std::atoi(argv[1]) : 10000;
+    std::cout << "average spawn to first use latency over " << iterations << " threads:\n";
+
+    spawn_to_first_use(iterations, [] { });     // warm up
+    auto const none = spawn_to_first_use(iterations, [] { });
+    std::cout << "none:   " << none << "us\n";
+
+    auto const string = spawn_to_first_use(iterations, [] {
+        myThreadData.tName = worker_name;
+        myThreadData.lName = worker_name;
+    });
+    std::cout << "string: " << string << "us\n";
+
+    auto const fixed = spawn_to_first_use(iterations, [] {
+        myThreadDataFixed.tName = worker_name;
+        myThreadDataFixed.lName = worker_name;
+    });
+    std::cout << "fixed:  " << fixed << "us\n";
+
+    auto const lazy = spawn_to_first_use(iterations, [] {
+        myThreadDataLazy().tName = worker_name;
+    });
+    std::cout << "lazy:   " << lazy << "us\n";
+
+    myThreadDataFixed.print("main():");
+    myThreadDataLazy().print("main() lazy:");
+}
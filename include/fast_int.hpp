@@ -0,0 +1,234 @@
+#if !defined(CPP17_FAST_INT_INCLUDE_HEADER_GUARD_)
+#define CPP17_FAST_INT_INCLUDE_HEADER_GUARD_
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Decimal integer parsing which consumes 8 digits per step, with SWAR ("SIMD within a register")
+ * arithmetic on a 64 bit word: the digits are validated by masking all 8 bytes at once, and
+ * combined pairwise - 8 digits into 4 two-digit values, into 2 four-digit values, into one - with
+ * three multiplications instead of eight. The longest 64 bit value takes three steps.
+ *
+ * fast_int::from_chars() keeps the contract of std::from_chars(first, last, value) for base 10:
+ * - an optional '-' for signed types only (no '+', no whitespace), then at least one digit,
+ * - on success `ptr` points past the last digit and `value` is set,
+ * - without digits it returns {first, invalid_argument},
+ * - if the value doesn't fit, it returns {past the last digit, result_out_of_range},
+ * and `value` is left unmodified on errors.
+ *
+ * from_chars_fixed() parses a field of a known width, all digits (e.g. "20261018" or a
+ * zero-padded ID), and parse_list() a whole list of delimited values into a vector.
+ *
+ * The words are loaded with memcpy in host byte order, so the SWAR steps assume a little endian
+ * host; on others, the plain loop is used.
+ */
+
+namespace fast_int {
+
+namespace detail {
+
+inline constexpr bool little_endian{
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#elif defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+    true
+#else
+    false
+#endif
+};
+
+// The digits at [p, p + n) as 8 bytes, padded with a non-digit.
+inline std::uint64_t load(char const* p, std::size_t n) noexcept
+{
+    std::uint64_t word;
+    if (n >= 8) {
+        std::memcpy(&word, p, 8);
+    }
+    else {
+        char bytes[8] = {'x', 'x', 'x', 'x', 'x', 'x', 'x', 'x'};
+        std::memcpy(bytes, p, n);
+        std::memcpy(&word, bytes, 8);
+    }
+    return word;
+}
+
+// The number of leading digits of a little endian word (0 to 8).
+inline unsigned leading_digits(std::uint64_t word) noexcept
+{
+    auto const t = word ^ 0x3030303030303030ull;     // '0'..'9' -> 0..9
+    // a byte isn't a digit if its high nibble isn't 0, or its low nibble is above 9 (+6 carries
+    // into the high nibble - without a carry into the next byte, as it's at most 0x0f + 6)
+    auto const bad = (t | ((t & 0x0f0f0f0f0f0f0f0full) + 0x0606060606060606ull))
+                     & 0xf0f0f0f0f0f0f0f0ull;
+    if (bad == 0) {
+        return 8;
+    }
+    // lowest set bit -> first non-digit byte
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(bad)) / 8;
+#else
+    unsigned n{0};
+    for (auto b = bad; (b & 0xff) == 0; b >>= 8) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// The value of the first n (1 to 8) digits of a little endian word.
+inline std::uint64_t digits_value(std::uint64_t word, unsigned n) noexcept
+{
+    // shift the digits to the top, the emptied low bytes (the first digits) count as zeros
+    auto v = (word & 0x0f0f0f0f0f0f0f0full) << (8 * (8 - n));
+    v = (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ffull;            // pairs of digits
+    v = (v * 100 + (v >> 16)) & 0x0000ffff0000ffffull;          // groups of 4 digits
+    return (v * 10000 + (v >> 32)) & 0xffffffffull;
+}
+
+struct Digits {
+    char const* end;
+    std::uint64_t value;
+    bool overflow;
+};
+
+// The value of the digits at `p` (in any number, leading zeros too), up to UINT64_MAX.
+inline Digits parse_digits(char const* p, char const* last) noexcept
+{
+    std::uint64_t value{0};
+    bool overflow{false};
+    if constexpr (little_endian) {
+        // leading zeros don't count towards the 19 digits which always fit
+        while (p != last && *p == '0') {
+            ++p;
+        }
+        auto const* const start = p;
+        for (;;) {
+            auto const left = static_cast<std::size_t>(last - p);
+            auto const word = load(p, left);
+            auto const n = leading_digits(word);
+            if (n == 0) {
+                break;
+            }
+            constexpr std::uint64_t pow10[]{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                                            100000000};
+            if (static_cast<std::size_t>(p - start) + n <= 19) {
+                value = value * pow10[n] + digits_value(word, n);
+            }
+            else {
+                for (unsigned i{0}; i < n && !overflow; ++i) {
+                    auto const d = static_cast<unsigned>(p[i] - '0');
+                    overflow = value > (std::numeric_limits<std::uint64_t>::max() - d) / 10;
+                    value = value * 10 + d;
+                }
+            }
+            p += n;
+            if (n < 8) {
+                break;
+            }
+        }
+    }
+    else {
+        for (; p != last && static_cast<unsigned>(*p - '0') < 10; ++p) {
+            auto const d = static_cast<unsigned>(*p - '0');
+            overflow = overflow || value > (std::numeric_limits<std::uint64_t>::max() - d) / 10;
+            value = value * 10 + d;
+        }
+    }
+    return Digits{p, value, overflow};
+}
+
+} // namespace detail
+
+// Like std::from_chars(first, last, value) with base 10, see above.
+template <typename T>
+std::from_chars_result from_chars(char const* first, char const* last, T& value) noexcept
+{
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "integer types only");
+    static_assert(sizeof(T) <= sizeof(std::uint64_t), "up to 64 bit");
+    using U = std::make_unsigned_t<T>;
+    bool const negative = std::is_signed_v<T> && first != last && *first == '-';
+    auto const* const p = negative ? first + 1 : first;
+    auto const digits = detail::parse_digits(p, last);
+    if (digits.end == p) {
+        return {first, std::errc::invalid_argument};
+    }
+    // the magnitude of the most negative value is one more than the maximum
+    auto const limit =
+        static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1u : 0u);
+    if (digits.overflow || digits.value > limit) {
+        return {digits.end, std::errc::result_out_of_range};
+    }
+    auto const magnitude = static_cast<U>(digits.value);
+    value = static_cast<T>(negative ? static_cast<U>(U{0} - magnitude) : magnitude);
+    return {digits.end, std::errc{}};
+}
+
+// Parses exactly `width` digits at `first` (no sign). Anything else in the field is an error.
+template <typename T>
+std::from_chars_result from_chars_fixed(char const* first, char const* last, std::size_t width,
+                                        T& value) noexcept
+{
+    using U = std::make_unsigned_t<T>;
+    if (width == 0 || static_cast<std::size_t>(last - first) < width) {
+        return {first, std::errc::invalid_argument};
+    }
+    std::uint64_t parsed{0};
+    if (detail::little_endian && width <= 19) {
+        // no search for the end, and nothing to check for overflow in 64 bits
+        for (auto const* p = first; p != first + width;) {
+            auto const left = static_cast<std::size_t>(first + width - p);
+            auto const n = static_cast<unsigned>(std::min<std::size_t>(left, 8));
+            auto const word = detail::load(p, static_cast<std::size_t>(last - p));
+            if (detail::leading_digits(word) < n) {
+                return {first, std::errc::invalid_argument};
+            }
+            constexpr std::uint64_t pow10[]{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                                            100000000};
+            parsed = parsed * pow10[n] + detail::digits_value(word, n);
+            p += n;
+        }
+    }
+    else {
+        auto const r = from_chars(first, first + width, parsed);
+        if (r.ec == std::errc::invalid_argument || r.ptr != first + width) {
+            return {first, std::errc::invalid_argument};
+        }
+        if (r.ec != std::errc{}) {
+            return r;
+        }
+    }
+    if (parsed > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+        return {first + width, std::errc::result_out_of_range};
+    }
+    value = static_cast<T>(static_cast<U>(parsed));
+    return {first + width, std::errc{}};
+}
+
+// Appends the values of a `delimiter` separated list to `values`, until the end or the first
+// error (returned as in from_chars, with ptr at the failed value). A trailing delimiter is fine.
+template <typename T>
+std::from_chars_result parse_list(char const* first, char const* last, char delimiter,
+                                  std::vector<T>& values)
+{
+    while (first != last) {
+        T value;
+        auto const r = from_chars(first, last, value);
+        if (r.ec != std::errc{} || (r.ptr != last && *r.ptr != delimiter)) {
+            return {first, r.ec != std::errc{} ? r.ec : std::errc::invalid_argument};
+        }
+        values.push_back(value);
+        first = r.ptr == last ? last : r.ptr + 1;
+    }
+    return {first, std::errc{}};
+}
+
+} // namespace fast_int
+
+#endif // CPP17_FAST_INT_INCLUDE_HEADER_GUARD_
@@ -0,0 +1,339 @@
+#if !defined(CPP17_MAPPED_FILE_INCLUDE_HEADER_GUARD_)
+#define CPP17_MAPPED_FILE_INCLUDE_HEADER_GUARD_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CPP17_MAPPED_FILE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * `mapped_file` makes the contents of a file available as one std::string_view, without copying
+ * it: a regular file is mapped into memory (mmap), and the kernel is told how it's going to be
+ * read (madvise), so it reads ahead - or fetches all of it at once with `advice::willneed`.
+ *
+ * lines() iterates over the file as string_views into the mapping - e.g. for a log processor,
+ * which otherwise std::getline()s each line into a std::string: a copy, and an allocation
+ * whenever a line is longer than any before. Each line is only a pointer and a length; the views
+ * stay valid as long as the mapped_file lives.
+ *
+ * Pipes, terminals and the like (and "-", standard input) can't be mapped. They are read in
+ * chunks into a buffer instead, and lines() hands out views into that buffer - each valid only
+ * until the iterator is incremented, and the lines can only be iterated once. A line longer than
+ * the buffer grows it. view() is empty for these. A read error ends the lines like the end of the
+ * stream; error() tells them apart.
+ *
+ * Like any reader of a mapping, the process gets SIGBUS if the file is truncated meanwhile.
+ */
+class mapped_file
+{
+public:
+    enum class advice {
+        normal,
+        sequential,     // aggressive read-ahead, pages behind the reader may be dropped early
+        willneed,       // start reading all of it right away
+    };
+
+    class line_range;
+
+    mapped_file() = default;
+
+    explicit mapped_file(std::filesystem::path const& path, advice adv = advice::sequential)
+    {
+        std::error_code ec;
+        open(path, adv, ec);
+        if (ec) {
+            throw std::filesystem::filesystem_error{"mapped_file", path, ec};
+        }
+    }
+
+    mapped_file(std::filesystem::path const& path, advice adv, std::error_code& ec) noexcept
+    {
+        open(path, adv, ec);
+    }
+
+    mapped_file(mapped_file&& other) noexcept { swap(other); }
+    mapped_file& operator=(mapped_file&& other) noexcept
+    {
+        mapped_file{std::move(other)}.swap(*this);
+        return *this;
+    }
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+    ~mapped_file() { close(); }
+
+    void swap(mapped_file& other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(stream_, other.stream_);
+        std::swap(buffer_, other.buffer_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(eof_, other.eof_);
+        std::swap(error_, other.error_);
+    }
+
+    bool is_open() const noexcept { return mapped_ || stream_.handle != stream::none; }
+    bool is_mapped() const noexcept { return mapped_; }
+
+    // The error which ended reading a stream early - none at its end, and for a mapped file.
+    std::error_code error() const noexcept { return error_; }
+
+    // All of a mapped file - empty if it's read as a stream.
+    std::string_view view() const noexcept { return {data_, size_}; }
+
+    // The lines, without their delimiter. A last line without delimiter is included.
+    line_range lines(char delimiter = '\n') noexcept;
+
+private:
+    static constexpr std::size_t chunk{256 * 1024};
+
+    // The source of a file which can't be mapped.
+    struct stream {
+#if defined(CPP17_MAPPED_FILE_POSIX)
+        using handle_type = int;
+        static constexpr handle_type none{-1};
+#else
+        using handle_type = std::FILE*;
+        static constexpr handle_type none{nullptr};
+#endif
+        handle_type handle{none};
+        bool owned{false};      // not stdin
+    };
+
+    void open(std::filesystem::path const& path, advice adv, std::error_code& ec) noexcept
+    {
+        ec.clear();
+        bool const standard_input = path == "-";
+#if defined(CPP17_MAPPED_FILE_POSIX)
+        int const fd = standard_input ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            ec.assign(errno, std::generic_category());
+            return;
+        }
+        struct stat st;
+        bool const regular = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        if (regular && st.st_size > 0) {
+            auto const size = static_cast<std::size_t>(st.st_size);
+            void* const p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                int const flag = adv == advice::sequential ? MADV_SEQUENTIAL
+                                 : adv == advice::willneed ? MADV_WILLNEED
+                                                           : MADV_NORMAL;
+                ::madvise(p, size, flag);
+                if (!standard_input) {
+                    ::close(fd);    // the mapping keeps the file
+                }
+                data_ = static_cast<char const*>(p);
+                size_ = size;
+                mapped_ = true;
+                return;
+            }
+        }
+        else if (regular) {     // empty: nothing to map, nothing to read
+            if (!standard_input) {
+                ::close(fd);
+            }
+            mapped_ = true;
+            return;
+        }
+        stream_ = stream{fd, !standard_input};
+#else
+        (void)adv;
+        auto* const file = standard_input ? stdin : std::fopen(path.string().c_str(), "rb");
+        if (!file) {
+            ec.assign(errno, std::generic_category());
+            return;
+        }
+        stream_ = stream{file, !standard_input};
+#endif
+    }
+
+    void close() noexcept
+    {
+#if defined(CPP17_MAPPED_FILE_POSIX)
+        if (mapped_ && size_ != 0) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+        if (stream_.owned) {
+            ::close(stream_.handle);
+        }
+#else
+        if (stream_.owned) {
+            std::fclose(stream_.handle);
+        }
+#endif
+    }
+
+    // Moves the unread bytes [first, last) of the buffer to its front and appends what can be
+    // read, growing the buffer if it's full. Returns false at the end of the stream (or on an
+    // error, which ends it as well, and is kept in error_).
+    bool refill(char const*& first, char const*& last)
+    {
+        auto const left = static_cast<std::size_t>(last - first);
+        if (left == capacity_) {
+            auto const capacity = std::max(capacity_ * 2, chunk);
+            auto grown = std::make_unique<char[]>(capacity);
+            if (left != 0) {
+                std::memcpy(grown.get(), first, left);
+            }
+            buffer_ = std::move(grown);
+            capacity_ = capacity;
+        }
+        else if (left != 0) {
+            std::memmove(buffer_.get(), first, left);
+        }
+        first = buffer_.get();
+        last = first + left;
+        auto const n = read_some(buffer_.get() + left, capacity_ - left);
+        if (n == 0) {
+            eof_ = true;
+            return false;
+        }
+        last += n;
+        return true;
+    }
+
+    std::size_t read_some(char* p, std::size_t size) noexcept
+    {
+#if defined(CPP17_MAPPED_FILE_POSIX)
+        for (;;) {
+            auto const n = ::read(stream_.handle, p, size);
+            if (n >= 0) {
+                return static_cast<std::size_t>(n);
+            }
+            if (errno != EINTR) {
+                error_.assign(errno, std::generic_category());
+                return 0;
+            }
+        }
+#else
+        auto const n = std::fread(p, 1, size, stream_.handle);
+        if (n == 0 && std::ferror(stream_.handle)) {
+            error_ = std::make_error_code(std::errc::io_error);
+        }
+        return n;
+#endif
+    }
+
+    char const* data_{nullptr};
+    std::size_t size_{0};
+    bool mapped_{false};
+    stream stream_{};
+    std::unique_ptr<char[]> buffer_{};
+    std::size_t capacity_{0};
+    bool eof_{false};
+    std::error_code error_{};
+};
+
+// A single pass over the lines of a mapped_file, see mapped_file::lines().
+class mapped_file::line_range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::string_view const*;
+        using reference = std::string_view const&;
+
+        iterator() = default;
+
+        reference operator*() const noexcept { return line_; }
+        pointer operator->() const noexcept { return &line_; }
+
+        iterator& operator++()
+        {
+            if (!range_->next(line_)) {
+                range_ = nullptr;
+            }
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        // only the end is reachable - there's no other position to compare to
+        friend bool operator==(iterator const& a, iterator const& b) noexcept
+        {
+            return a.range_ == b.range_;
+        }
+        friend bool operator!=(iterator const& a, iterator const& b) noexcept { return !(a == b); }
+
+    private:
+        friend class line_range;
+        explicit iterator(line_range* range) : range_{range} { ++*this; }
+
+        line_range* range_{nullptr};
+        std::string_view line_{};
+    };
+
+    iterator begin() { return iterator{this}; }
+    iterator end() noexcept { return iterator{}; }
+
+private:
+    friend class mapped_file;
+    line_range(mapped_file& file, char delimiter) noexcept
+        : file_{&file},
+          first_{file.data_},
+          last_{file.data_ + file.size_},
+          delimiter_{delimiter}
+    {
+    }
+
+    bool next(std::string_view& line)
+    {
+        for (;;) {
+            auto const size = static_cast<std::size_t>(last_ - first_);
+            auto const* const end =
+                size != 0 ? static_cast<char const*>(std::memchr(first_, delimiter_, size))
+                          : nullptr;
+            if (end) {
+                line = std::string_view{first_, static_cast<std::size_t>(end - first_)};
+                first_ = end + 1;
+                return true;
+            }
+            if (file_->mapped_ || file_->eof_ || !file_->refill(first_, last_)) {
+                if (size == 0) {
+                    return false;
+                }
+                line = std::string_view{first_, size};  // without delimiter at the end
+                first_ = last_;
+                return true;
+            }
+        }
+    }
+
+    mapped_file* file_;
+    char const* first_;     // the unread part of the mapping or buffer
+    char const* last_;
+    char delimiter_;
+};
+
+inline mapped_file::line_range mapped_file::lines(char delimiter) noexcept
+{
+    return line_range{*this, delimiter};
+}
+
+#endif // CPP17_MAPPED_FILE_INCLUDE_HEADER_GUARD_
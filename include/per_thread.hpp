@@ -0,0 +1,221 @@
+#if !defined(CPP17_PER_THREAD_INCLUDE_HEADER_GUARD_)
+#define CPP17_PER_THREAD_INCLUDE_HEADER_GUARD_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// C++17 provides the minimum offset between two objects to avoid false sharing as
+// std::hardware_destructive_interference_size, but not all standard libraries implement it yet.
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+inline constexpr std::size_t destructive_interference_size{
+    std::hardware_destructive_interference_size};
+#else
+// GCC (and clang, which defines __GNUC__ as well) warn about any use of the std:: constant since
+// it depends on -mtune, use the common cache line size instead.
+inline constexpr std::size_t destructive_interference_size{64};
+#endif
+
+// A small index, unique among all the currently running threads. It's assigned on first use in a
+// thread and handed back when the thread exits, so the indices stay dense even with many
+// short-lived threads.
+class ThreadSlotIndex
+{
+public:
+    ThreadSlotIndex() : index_{acquire()} { }
+    ThreadSlotIndex(ThreadSlotIndex const&) = delete;
+    ThreadSlotIndex& operator=(ThreadSlotIndex const&) = delete;
+    ~ThreadSlotIndex() { release(index_); }
+
+    std::size_t get() const noexcept { return index_; }
+
+private:
+    static std::size_t acquire()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (free_.empty()) {
+            return next_++;
+        }
+        auto const index = free_.back();
+        free_.pop_back();
+        return index;
+    }
+
+    static void release(std::size_t index) noexcept
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        try {
+            free_.push_back(index);
+        }
+        catch (...) {
+            // the index is leaked, but remains unique
+        }
+    }
+
+    inline static std::mutex mutex_{};
+    inline static std::vector<std::size_t> free_{};
+    inline static std::size_t next_{0};
+
+    std::size_t index_;
+};
+
+inline thread_local ThreadSlotIndex threadSlotIndex;    // one index per thread
+
+/**
+ * `per_thread<T>` holds one T per thread, each in its own cache line(s), so that threads updating
+ * their own slot never invalidate each other's caches (false sharing).
+ *
+ * Unlike a `thread_local` variable, all the slots can be visited from any thread - e.g. to reduce
+ * per-thread counters on demand. If the slots are read while other threads are still writing,
+ * T has to be an atomic type (see `per_thread_counter`). The slot of a thread is reused by a later
+ * thread once it exits, its value is kept.
+ *
+ * A thread's slot is found by its ThreadSlotIndex, which is shared by all the instances - so it
+ * depends on all the threads of the process, not only those using this instance. The slots are
+ * therefore allocated in chunks as they're needed, `initial_slots` first, then twice as many each
+ * time; chunks never move, so a reference from local() stays valid. Sizing the first chunk for
+ * the threads which will use the instance (e.g. `threads + 1`) only saves that allocation.
+ */
+template <typename T>
+class per_thread
+{
+public:
+    explicit per_thread(std::size_t initial_slots = 64)
+        : first_size_{std::max<std::size_t>(initial_slots, 1)}
+    {
+        chunks_[0].store(new Slot[first_size_], std::memory_order_relaxed);
+    }
+
+    per_thread(per_thread const&) = delete;
+    per_thread& operator=(per_thread const&) = delete;
+
+    ~per_thread()
+    {
+        for (auto& chunk : chunks_) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    // The slot of the calling thread.
+    T& local()
+    {
+        auto const [chunk, offset] = locate(threadSlotIndex.get());
+        auto* slots = chunks_[chunk].load(std::memory_order_acquire);
+        if (!slots) {
+            slots = allocate(chunk);
+        }
+        return slots[offset].value;
+    }
+
+    // Call f(value) for every slot.
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        for_each_chunk([&f](Slot const* slots, std::size_t n) {
+            for (std::size_t i{0}; i < n; ++i) {
+                f(slots[i].value);
+            }
+        });
+    }
+
+    // Same for mutable access, e.g. to move the results out once the threads are done.
+    template <typename F>
+    void for_each(F&& f)
+    {
+        for_each_chunk([&f](Slot* slots, std::size_t n) {
+            for (std::size_t i{0}; i < n; ++i) {
+                f(slots[i].value);
+            }
+        });
+    }
+
+    // Fold all slots into `init`, as op(op(init, slot0), slot1)...
+    template <typename R, typename Op>
+    R combine(R init, Op op) const
+    {
+        for_each([&](T const& value) { init = op(std::move(init), value); });
+        return init;
+    }
+
+private:
+    struct alignas(destructive_interference_size) Slot {
+        T value{};
+    };
+
+    // Chunk k holds first_size_ << k slots - 48 chunks are more than any number of threads.
+    static constexpr std::size_t max_chunks{48};
+
+    std::pair<std::size_t, std::size_t> locate(std::size_t index) const noexcept
+    {
+        auto const n = index / first_size_ + 1;
+        std::size_t chunk{0};
+        while (n >> (chunk + 1)) {
+            ++chunk;
+        }
+        return {chunk, index - first_size_ * ((std::size_t{1} << chunk) - 1)};
+    }
+
+    Slot* allocate(std::size_t chunk)
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto* slots = chunks_[chunk].load(std::memory_order_relaxed);
+        if (!slots) {   // not allocated by another thread meanwhile
+            slots = new Slot[first_size_ << chunk];
+            chunks_[chunk].store(slots, std::memory_order_release);
+        }
+        return slots;
+    }
+
+    template <typename F>
+    void for_each_chunk(F&& f) const
+    {
+        for (std::size_t k{0}; k < max_chunks; ++k) {
+            if (auto* const slots = chunks_[k].load(std::memory_order_acquire)) {
+                f(static_cast<Slot const*>(slots), first_size_ << k);
+            }
+        }
+    }
+
+    template <typename F>
+    void for_each_chunk(F&& f)
+    {
+        for (std::size_t k{0}; k < max_chunks; ++k) {
+            if (auto* const slots = chunks_[k].load(std::memory_order_acquire)) {
+                f(slots, first_size_ << k);
+            }
+        }
+    }
+
+    std::size_t const first_size_;
+    std::array<std::atomic<Slot*>, max_chunks> chunks_{};
+    std::mutex mutex_{};
+};
+
+// Per-thread counters, which can be read and summed up at any time without locking.
+template <typename T>
+using per_thread_counter = per_thread<std::atomic<T>>;
+
+// Since only the owning thread writes to its slot, an increment doesn't need a (locked)
+// read-modify-write instruction - a relaxed load and store are enough.
+// In hot loops, call local() once and do the same load/store on the returned slot.
+template <typename T>
+void add(per_thread_counter<T>& counter, typename std::atomic<T>::value_type value)
+{
+    auto& slot = counter.local();
+    slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+template <typename T>
+T sum(per_thread_counter<T> const& counter) noexcept
+{
+    return counter.combine(T{}, [](T acc, std::atomic<T> const& slot) {
+        return acc + slot.load(std::memory_order_relaxed);
+    });
+}
+
+#endif // CPP17_PER_THREAD_INCLUDE_HEADER_GUARD_
@@ -0,0 +1,242 @@
+#if !defined(CPP17_PROFILER_INCLUDE_HEADER_GUARD_)
+#define CPP17_PROFILER_INCLUDE_HEADER_GUARD_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * A scoped-zone profiler: a `ProfileZone` records the time between its construction and
+ * destruction under a static name into a buffer owned by the current thread. Nested zones nest
+ * in the timeline. Nothing is formatted or written during measurement - the events are exported
+ * afterwards with `Profiler::write_chrome_trace()`, as Chrome trace-event JSON which can be
+ * loaded into chrome://tracing or https://ui.perfetto.dev.
+ *
+ * The profiler is disabled until `enable()` is called - a disabled zone only reads a flag.
+ *
+ * Recording an event is lock-free: each thread appends to its own buffer and publishes the new
+ * event count with a release store. A buffer grows in chunks of `chunk_size` events as they're
+ * recorded, up to its capacity; events beyond it are dropped and counted. A mutex is taken only
+ * once per thread, to get its buffer. Buffers are owned by the profiler, so they outlive their
+ * threads and can be exported once the workers are joined - and the buffer of a thread which has
+ * exited is taken by the next new thread, which adds its events to the same track. So a program
+ * which starts new threads again and again keeps only as many buffers as it had threads at once.
+ */
+class Profiler
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    static constexpr std::size_t chunk_size{1024};
+
+    struct Event {
+        char const* name{nullptr};  // static string - only the pointer is stored
+        clock_type::time_point begin{};
+        clock_type::time_point end{};
+    };
+
+    static Profiler& instance() noexcept
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler(Profiler const&) = delete;
+    Profiler& operator=(Profiler const&) = delete;
+
+    void enable(bool on = true) noexcept { enabled_.store(on, std::memory_order_relaxed); }
+    bool enabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    // Capacity of the buffers created after this call - a reused buffer keeps its capacity.
+    void set_events_per_thread(std::size_t n) noexcept
+    {
+        events_per_thread_.store(n, std::memory_order_relaxed);
+    }
+
+    // Shown as the name of the calling thread's track in the timeline. `name` has to be static.
+    void set_thread_name(char const* name) { local_buffer().name = name; }
+
+    void record(char const* name, clock_type::time_point begin, clock_type::time_point end)
+    {
+        auto& buffer = local_buffer();
+        auto const n = buffer.count.load(std::memory_order_relaxed);
+        if (n == buffer.capacity) {
+            buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+            return;
+        }
+        auto& chunk = buffer.chunks[n / chunk_size];
+        if (!chunk) {
+            chunk = std::make_unique<Event[]>(chunk_size);  // published by the count below
+        }
+        chunk[n % chunk_size] = Event{name, begin, end};
+        buffer.count.store(n + 1, std::memory_order_release);
+    }
+
+    std::uint64_t dropped() const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        std::uint64_t total{0};
+        for (auto const& buffer : buffers_) {
+            total += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Writes all events recorded so far. Events still being recorded concurrently may or may not
+    // be included, but are never torn.
+    void write_chrome_trace(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto const micros = [this](clock_type::time_point tp) {
+            return std::chrono::duration<double, std::micro>{tp - start_}.count();
+        };
+        // timestamps are in microseconds, keep nanosecond resolution without exponent notation
+        auto const flags = os.flags(std::ios_base::fixed);
+        auto const precision = os.precision(3);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        char const* sep = "";
+        for (auto const& buffer : buffers_) {
+            if (buffer->name) {
+                os << sep << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << buffer->tid
+                   << R"(,"args":{"name":)";
+                write_string(os, buffer->name);
+                os << "}}";
+                sep = ",\n";
+            }
+            auto const n = buffer->count.load(std::memory_order_acquire);
+            for (std::size_t i{0}; i < n; ++i) {
+                auto const& e = buffer->chunks[i / chunk_size][i % chunk_size];
+                os << sep << R"({"ph":"X","pid":1,"tid":)" << buffer->tid << R"(,"name":)";
+                write_string(os, e.name);
+                os << R"(,"ts":)" << micros(e.begin) << R"(,"dur":)"
+                   << micros(e.end) - micros(e.begin) << "}";
+                sep = ",\n";
+            }
+        }
+        os << "\n]}\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+private:
+    Profiler() = default;
+
+    struct ThreadBuffer {
+        ThreadBuffer(std::uint32_t id, std::size_t cap)
+            : chunks{std::make_unique<std::unique_ptr<Event[]>[]>((cap + chunk_size - 1)
+                                                                  / chunk_size)},
+              capacity{cap}, tid{id} { }
+        ThreadBuffer(ThreadBuffer const&) = delete;
+        ThreadBuffer& operator=(ThreadBuffer const&) = delete;
+
+        std::unique_ptr<std::unique_ptr<Event[]>[]> chunks;     // allocated when first used
+        std::size_t const capacity;
+        std::atomic<std::size_t> count{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::uint32_t const tid;
+        char const* name{nullptr};
+    };
+
+    // Holds the buffer of a thread, and gives it back to the profiler when the thread exits.
+    struct Lease {
+        Lease() = default;
+        Lease(Lease const&) = delete;
+        Lease& operator=(Lease const&) = delete;
+        ~Lease()
+        {
+            if (buffer) {
+                auto& profiler = instance();
+                std::lock_guard<std::mutex> lock{profiler.mutex_};
+                try {
+                    profiler.free_.push_back(buffer);
+                }
+                catch (...) {
+                    // not reused then
+                }
+            }
+        }
+
+        ThreadBuffer* buffer{nullptr};
+    };
+
+    ThreadBuffer& local_buffer()
+    {
+        // one buffer per thread - on the first event of the thread, one left by a thread which
+        // has exited, or a new one
+        static thread_local Lease lease;
+        if (!lease.buffer) {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (!free_.empty()) {
+                lease.buffer = free_.back();
+                free_.pop_back();
+            }
+            else {
+                buffers_.push_back(std::make_unique<ThreadBuffer>(
+                    static_cast<std::uint32_t>(buffers_.size() + 1),
+                    events_per_thread_.load(std::memory_order_relaxed)));
+                lease.buffer = buffers_.back().get();
+            }
+        }
+        return *lease.buffer;
+    }
+
+    static void write_string(std::ostream& os, char const* s)
+    {
+        os << '"';
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') {
+                os << '\\';
+            }
+            os << *s;
+        }
+        os << '"';
+    }
+
+    clock_type::time_point const start_{clock_type::now()};
+    std::atomic<bool> enabled_{false};
+    std::atomic<std::size_t> events_per_thread_{1 << 16};
+    mutable std::mutex mutex_{};
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_{};
+    std::vector<ThreadBuffer*> free_{};     // of threads which have exited
+};
+
+// Records the lifetime of the zone object under `name`, which has to be a static string:
+//     { ProfileZone zone{"load"}; ... }
+class ProfileZone
+{
+public:
+    explicit ProfileZone(char const* name) noexcept
+        : name_{Profiler::instance().enabled() ? name : nullptr}
+    {
+        if (name_) {
+            begin_ = Profiler::clock_type::now();
+        }
+    }
+
+    ProfileZone(ProfileZone const&) = delete;
+    ProfileZone& operator=(ProfileZone const&) = delete;
+
+    ~ProfileZone()
+    {
+        if (name_) {
+            try {
+                Profiler::instance().record(name_, begin_, Profiler::clock_type::now());
+            }
+            catch (...) {
+                // registering the thread's buffer failed - lose the event
+            }
+        }
+    }
+
+private:
+    char const* name_;
+    Profiler::clock_type::time_point begin_{};
+};
+
+#endif // CPP17_PROFILER_INCLUDE_HEADER_GUARD_